@@ -0,0 +1,333 @@
+#include "graph.h"
+
+/**
+ * File: filtered_view.h
+ * Description: This file contains the definition and implementation of the
+ *              FilteredView class, a read-only view over a Graph that leaves
+ *              out vertices and edges without copying the graph.
+ */
+
+#ifndef _FILTERED_VIEW_H_
+#define _FILTERED_VIEW_H_
+
+namespace GraphNameSpace
+{
+  /**
+  * Description: A view over a graph that lets through the vertices set in
+  * a bitmap and the edges accepted by an edge filter. Vertices keep their
+  * positions in the underlying graph, so positionCount() is that of the
+  * graph and results of the generic algorithms (kruskalSpanningForest,
+  * kahnTopologicalSort, dagPaths, ...) index the same way as on the graph;
+  * vertexCount() and edgeCount() count what the view lets through.
+  * The view reads the graph directly and is invalidated when it changes.
+  */
+    template<class Type, class EdgeFilter = AllEdges, class KeyHash = VertexKeyHash<Type> >
+    class FilteredView
+    {
+    public:
+
+    /**
+      * Function: FilteredView - The overloaded constructor with a graph
+      * Description: Constructs a view letting through every vertex
+      * Function input: the graph and an edge filter
+      * Function output: None.
+      * Precondition: none.
+      * Postcondition: view created over the graph
+      */
+      explicit FilteredView(const Graph<Type, KeyHash>& graph, EdgeFilter keepEdge = EdgeFilter());
+
+    /**
+      * Function: FilteredView - The overloaded constructor with a vertex mask
+      * Description: Constructs a view letting through the vertices whose
+      *              bit is set, bit i of word i / 64 stands for position i
+      * Function input: the graph, the vertex bitmap and an edge filter
+      * Function output: None.
+      * Precondition: none.
+      * Postcondition: view created over the graph, missing words count as 0
+      */
+      FilteredView(const Graph<Type, KeyHash>& graph, const std::vector<unsigned long long>& vertexMask,
+                   EdgeFilter keepEdge = EdgeFilter());
+
+    /**
+      * Function: includeVertex / excludeVertex
+      * Description: lets a vertex through the view or leaves it out
+      * Function input: a vertex position
+      * Function output: None.
+      * Precondition: 0 <= position < positionCount()
+      * Postcondition: the vertex bitmap is updated
+      */
+      void includeVertex(int vertexIndex);
+      void excludeVertex(int vertexIndex);
+
+    /**
+      * Function: containsVertex
+      * Description: checks if a position holds a vertex that the view lets through
+      * Function input: a vertex position
+      * Function output: None.
+      * Precondition: none
+      * Postcondition: returns true if the vertex is in the view
+      */
+      bool containsVertex(int vertexIndex) const;
+
+    /**
+      * Function: positionCount
+      * Description: returns the number of positions in the underlying graph
+      * Function input: none
+      * Function output: the number of positions
+      * Precondition: none
+      * Postcondition: the number of positions is returned
+      */
+      int positionCount() const;
+
+    /**
+      * Function: vertexCount
+      * Description: returns the number of vertices the view lets through
+      * Function input: none
+      * Function output: the number of vertices in the view
+      * Precondition: none
+      * Postcondition: the number of vertices in the view is returned
+      */
+      int vertexCount() const;
+
+    /**
+      * Function: edgeCount
+      * Description: counts the edges the view lets through, undirected
+      *              edges once, by running the edge filter over the graph
+      * Function input: none
+      * Function output: the number of edges in the view
+      * Precondition: none
+      * Postcondition: the number of edges in the view is returned
+      */
+      int edgeCount() const;
+
+    /**
+      * Function: vertexMask
+      * Description: gives the bitmap of vertices in the view
+      * Function input: none
+      * Function output: one bit per position
+      * Precondition: none
+      * Postcondition: the bitmap is returned
+      */
+      const std::vector<unsigned long long>& vertexMask() const;
+
+    /**
+      * Function: infoAt
+      * Description: returns the info of the vertex at a position
+      * Function input: a vertex position
+      * Function output: the info
+      * Precondition: the position holds a vertex
+      * Postcondition: the info is returned
+      */
+      const Type& infoAt(int vertexIndex) const { return graph->infoAt(vertexIndex); }
+
+    /**
+      * Function: forEachVertex
+      * Description: calls func(vertexIndex, info) for every vertex in the view
+      * Function input: a callable
+      * Function output: none
+      * Precondition: func must not modify the graph
+      * Postcondition: func has been called once per vertex in position order
+      */
+      template<class Func>
+      void forEachVertex(Func func) const;
+
+    /**
+      * Function: forEachNeighbor
+      * Description: calls func(connIndex, edgeWeight) for every edge of a
+      *              vertex that the view lets through, nothing if the vertex
+      *              is left out
+      * Function input: the position of the vertex and a callable
+      * Function output: none
+      * Precondition: func must not modify the graph
+      * Postcondition: func has been called once per edge in the view
+      */
+      template<class Func>
+      void forEachNeighbor(int vertexIndex, Func func) const;
+
+    /**
+      * Function: forEachEdge
+      * Description: calls func(fromIndex, toIndex, edgeWeight) for every
+      *              edge in the view, undirected edges once from each end
+      * Function input: a callable
+      * Function output: none
+      * Precondition: func must not modify the graph
+      * Postcondition: func has been called once per adjacency entry in the view
+      */
+      template<class Func>
+      void forEachEdge(Func func) const;
+
+    /**
+      * Function: materialize
+      * Description: copies the view into a compact graph
+      * Function input: the number of threads (0 for all cores)
+      * Function output: a graph holding the vertices and edges of the view
+      * Precondition: none
+      * Postcondition: vertices keep their relative order
+      */
+      Graph<Type, KeyHash> materialize(int threads = 0) const;
+
+      Weight weigh;  // weight of the underlying graph
+      Direction direction; // direction of the underlying graph
+
+    private:
+      const Graph<Type, KeyHash>* graph; // the graph being viewed
+      std::vector<unsigned long long> mask; // bit i set if position i is in the view
+      EdgeFilter keepEdge; // edges to let through
+    };
+
+  template<class Type, class EdgeFilter, class KeyHash>
+  FilteredView<Type, EdgeFilter, KeyHash>::FilteredView(const Graph<Type, KeyHash>& graph, EdgeFilter keepEdge)
+    : weigh(graph.weigh), direction(graph.direction), graph(&graph), keepEdge(keepEdge)
+  {
+    int positions = graph.positionCount();
+    mask.assign((positions + 63) / 64, ~0ULL);
+    if(positions % 64 != 0)
+      mask.back() = (1ULL << (positions % 64)) - 1;
+  }
+
+  template<class Type, class EdgeFilter, class KeyHash>
+  FilteredView<Type, EdgeFilter, KeyHash>::FilteredView(const Graph<Type, KeyHash>& graph,
+                                                        const std::vector<unsigned long long>& vertexMask,
+                                                        EdgeFilter keepEdge)
+    : weigh(graph.weigh), direction(graph.direction), graph(&graph), mask(vertexMask), keepEdge(keepEdge)
+  {
+    int positions = graph.positionCount();
+    mask.resize((positions + 63) / 64, 0);
+    if(positions % 64 != 0)
+      mask.back() &= (1ULL << (positions % 64)) - 1;
+  }
+
+  template<class Type, class EdgeFilter, class KeyHash>
+  void FilteredView<Type, EdgeFilter, KeyHash>::includeVertex(int vertexIndex)
+  {
+    mask[vertexIndex / 64] |= 1ULL << (vertexIndex % 64);
+  }
+
+  template<class Type, class EdgeFilter, class KeyHash>
+  void FilteredView<Type, EdgeFilter, KeyHash>::excludeVertex(int vertexIndex)
+  {
+    mask[vertexIndex / 64] &= ~(1ULL << (vertexIndex % 64));
+  }
+
+  template<class Type, class EdgeFilter, class KeyHash>
+  inline bool FilteredView<Type, EdgeFilter, KeyHash>::containsVertex(int vertexIndex) const
+  {
+    return graph->containsVertex(vertexIndex) && ((mask[vertexIndex / 64] >> (vertexIndex % 64)) & 1ULL);
+  }
+
+  template<class Type, class EdgeFilter, class KeyHash>
+  int FilteredView<Type, EdgeFilter, KeyHash>::positionCount() const
+  {
+    return graph->positionCount();
+  }
+
+  template<class Type, class EdgeFilter, class KeyHash>
+  int FilteredView<Type, EdgeFilter, KeyHash>::vertexCount() const
+  {
+    // the mask has no bits past the positions of the graph
+    int selected = 0;
+    for(size_t w = 0; w < mask.size(); w++)
+      selected += __builtin_popcountll(mask[w]);
+    return selected;
+  }
+
+  template<class Type, class EdgeFilter, class KeyHash>
+  int FilteredView<Type, EdgeFilter, KeyHash>::edgeCount() const
+  {
+    int edges = 0;
+    int positions = graph->positionCount();
+    for(int i = 0; i < positions; i++)
+      forEachEdgeOnce(*this, i, [&](int, int) { edges++; });
+    return edges;
+  }
+
+  template<class Type, class EdgeFilter, class KeyHash>
+  const std::vector<unsigned long long>& FilteredView<Type, EdgeFilter, KeyHash>::vertexMask() const
+  {
+    return mask;
+  }
+
+  template<class Type, class EdgeFilter, class KeyHash>
+  template<class Func>
+  inline void FilteredView<Type, EdgeFilter, KeyHash>::forEachVertex(Func func) const
+  {
+    graph->forEachVertex([&](int vertexIndex, const Type& info)
+    {
+      if(containsVertex(vertexIndex))
+        func(vertexIndex, info);
+    });
+  }
+
+  template<class Type, class EdgeFilter, class KeyHash>
+  template<class Func>
+  inline void FilteredView<Type, EdgeFilter, KeyHash>::forEachNeighbor(int vertexIndex, Func func) const
+  {
+    if(!containsVertex(vertexIndex))
+      return;
+    graph->forEachNeighbor(vertexIndex, [&](int connIndex, int edgeWeight)
+    {
+      if(containsVertex(connIndex) && keepEdge(vertexIndex, connIndex, edgeWeight))
+        func(connIndex, edgeWeight);
+    });
+  }
+
+  template<class Type, class EdgeFilter, class KeyHash>
+  template<class Func>
+  inline void FilteredView<Type, EdgeFilter, KeyHash>::forEachEdge(Func func) const
+  {
+    int positions = graph->positionCount();
+    for(int i = 0; i < positions; i++)
+    {
+      forEachNeighbor(i, [&](int connIndex, int edgeWeight)
+      {
+        func(i, connIndex, edgeWeight);
+      });
+    }
+  }
+
+  template<class Type, class EdgeFilter, class KeyHash>
+  Graph<Type, KeyHash> FilteredView<Type, EdgeFilter, KeyHash>::materialize(int threads) const
+  {
+    std::vector<int> selected;
+    int positions = graph->positionCount();
+    for(int i = 0; i < positions; i++)
+    {
+      if(containsVertex(i))
+        selected.push_back(i);
+    }
+    return graph->inducedSubgraph(selected, keepEdge, threads);
+  }
+
+  /**
+  * Function: filterVertices / filterEdges / filterGraph
+  * Description: build a view from a vertex predicate, called as
+  *              keepVertex(vertexIndex, info), and/or an edge filter
+  * Function input: the graph and the predicates
+  * Function output: the view
+  */
+  template<class Type, class KeyHash, class VertexPredicate, class EdgeFilter>
+  FilteredView<Type, EdgeFilter, KeyHash> filterGraph(const Graph<Type, KeyHash>& graph, VertexPredicate keepVertex,
+                                                      EdgeFilter keepEdge)
+  {
+    std::vector<unsigned long long> mask((graph.positionCount() + 63) / 64, 0);
+    graph.forEachVertex([&](int vertexIndex, const Type& info)
+    {
+      if(keepVertex(vertexIndex, info))
+        mask[vertexIndex / 64] |= 1ULL << (vertexIndex % 64);
+    });
+    return FilteredView<Type, EdgeFilter, KeyHash>(graph, mask, keepEdge);
+  }
+
+  template<class Type, class KeyHash, class VertexPredicate>
+  FilteredView<Type, AllEdges, KeyHash> filterVertices(const Graph<Type, KeyHash>& graph, VertexPredicate keepVertex)
+  {
+    return filterGraph(graph, keepVertex, AllEdges());
+  }
+
+  template<class Type, class KeyHash, class EdgeFilter>
+  FilteredView<Type, EdgeFilter, KeyHash> filterEdges(const Graph<Type, KeyHash>& graph, EdgeFilter keepEdge)
+  {
+    return FilteredView<Type, EdgeFilter, KeyHash>(graph, keepEdge);
+  }
+}
+#endif
@@ -1,6 +1,14 @@
 #include<iostream>
 #include<iomanip>
 #include <stdexcept>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <climits>
+#include <functional>
+#include <unordered_map>
 
 /**
  * File: graph.h
@@ -25,21 +33,415 @@ namespace GraphNameSpace
       int edgeWeight; // weight if its a weighted graph
     };
   /**
-  * Description: A struct representing a vertex
-  */  
+  * Description: A stable name for a vertex, given out by insertVertex.
+  * Unlike a position it does not change when other vertices are deleted.
+  * The slot is given to a new vertex once its own vertex is deleted, with
+  * the next generation, so the old handle doesn't name the new vertex.
+  */
+    struct VertexHandle
+    {
+      unsigned int id; // slot of the vertex in the info column
+      unsigned int generation; // times the slot had been given back when the handle was made
+      
+      bool operator==(const VertexHandle& other) const { return id == other.id && generation == other.generation; }
+      bool operator!=(const VertexHandle& other) const { return !(*this == other); }
+    };
+    
+    const VertexHandle NO_VERTEX = {0xffffffffu, 0xffffffffu}; // handle of a vertex that isn't in the graph
+    
+    const int MAX_VERTICES = 100; // vertices a graph can hold
+    const int MAX_ADJACENT = 100; // entries an adjacency list can hold
+    
+  /**
+  * Description: Default hash used to intern vertex info into handles. It is
+  * std::hash<Type>, so it only compiles for a Type std::hash covers; for any
+  * other Type either specialize VertexKeyHash or pass a hasher as the second
+  * template argument of Graph. Either way Type needs operator==.
+  */
+    template<class Type>
+    struct VertexKeyHash : std::hash<Type>
+    {
+    };
+    
+  /**
+  * Description: A lightweight read-only range over the adjacency list of a
+  * vertex. Each element exposes the index of the vertex on the other end
+  * (connIndex) and the weight of the edge (edgeWeight).
+  */
     template<class Type>
-    struct Vertex
+    class AdjacencyRange
     {
-      Type info;	 // info holded by the vertex
-      int vertexIndex; // position in the graph
-      int countAdj;	// number of adjacent vertices to this vertex
-      ConnectedVertices<Type> edge[100]; // and array of adjuscent vertices
+    public:
+      typedef const ConnectedVertices<Type>* iterator;
+
+      AdjacencyRange(iterator first, iterator last) : first(first), last(last) {}
+
+      iterator begin() const { return first; }
+      iterator end() const { return last; }
+      int size() const { return static_cast<int>(last - first); }
+      bool empty() const { return first == last; }
+
+    private:
+      iterator first;
+      iterator last;
     };
     
     enum Weight{WEIGHTED, UNWEIGHTED};
     enum Direction{DIRECTED, UNDIRECTED};
+    enum SpanningAlgorithm{KRUSKAL, BORUVKA};
     
-    template<class Type>
+  /**
+  * Description: An edge given by the positions of its two vertices
+  */
+    struct WeightedEdge
+    {
+      int fromIndex; // position of the vertex the edge starts from
+      int toIndex; // position of the vertex the edge goes to
+      int edgeWeight; // weight of the edge
+    };
+    
+  /**
+  * Description: Edge filters take (fromIndex, toIndex, edgeWeight) and
+  * return true to keep the edge. On undirected graphs a filter must give
+  * the same answer for both directions of an edge.
+  */
+    struct AllEdges
+    {
+      bool operator()(int, int, int) const { return true; }
+    };
+    
+    struct MinimumWeight
+    {
+      explicit MinimumWeight(int threshold) : threshold(threshold) {}
+      bool operator()(int, int, int edgeWeight) const { return edgeWeight >= threshold; }
+      int threshold; // smallest weight that is kept
+    };
+    
+  /**
+  * Description: The result of a minimum spanning forest computation, one
+  * tree per connected component
+  */
+    struct SpanningForest
+    {
+      std::vector<WeightedEdge> edges; // the chosen edges
+      long long totalWeight; // sum of the weights of the chosen edges
+    };
+    
+  /**
+  * Description: The result of a topological sort. Arrays are indexed by
+  * vertex position unless noted otherwise.
+  */
+    struct TopologicalOrder
+    {
+      std::vector<int> order; // vertex positions in topological order
+      std::vector<int> position; // index of each vertex in order, -1 if it is on or behind a cycle
+      std::vector<int> level; // frontier batch each vertex was emitted in, -1 if never emitted
+      bool acyclic; // true if every vertex was emitted
+      std::vector<int> cycle; // one directed cycle as vertex positions when not acyclic
+    };
+    
+    const long long UNREACHABLE = LLONG_MAX; // path length of a vertex that cannot be reached
+    
+  /**
+  * Description: Path lengths over a DAG, indexed by vertex position.
+  * Vertices that cannot be reached hold UNREACHABLE.
+  */
+    struct DagPaths
+    {
+      std::vector<long long> distance; // best path length ending at each vertex
+      std::vector<int> predecessor; // previous vertex on that path, -1 at the start
+      bool acyclic; // false if the graph had a cycle and nothing was computed
+    };
+    
+  /**
+  * Description: Union-find over vertex positions with union by rank and
+  * path halving
+  */
+    class DisjointSet
+    {
+    public:
+      explicit DisjointSet(int size = 0) { reset(size); }
+      
+      void reset(int size)
+      {
+        parent.resize(size);
+        rank.assign(size, 0);
+        for(int i = 0; i < size; i++)
+          parent[i] = i;
+      }
+      
+      int add()
+      {
+        parent.push_back(static_cast<int>(parent.size()));
+        rank.push_back(0);
+        return parent.back();
+      }
+      
+      int size() const { return static_cast<int>(parent.size()); }
+      
+      int find(int x)
+      {
+        while(parent[x] != x)
+        {
+          parent[x] = parent[parent[x]];
+          x = parent[x];
+        }
+        return x;
+      }
+      
+      // find without path halving, safe to call from several threads at once
+      int root(int x) const
+      {
+        while(parent[x] != x)
+          x = parent[x];
+        return x;
+      }
+      
+      // returns false if both were already in the same set
+      bool unite(int a, int b)
+      {
+        a = find(a);
+        b = find(b);
+        if(a == b)
+          return false;
+        if(rank[a] < rank[b])
+          std::swap(a, b);
+        parent[b] = a;
+        if(rank[a] == rank[b])
+          rank[a]++;
+        return true;
+      }
+      
+    private:
+      std::vector<int> parent;
+      std::vector<unsigned char> rank;
+    };
+    
+  /**
+  * Function: resolveThreadCount
+  * Description: picks the number of threads to use for a piece of work
+  * Function input: requested threads (0 or less means all cores) and the
+  *                 number of work items
+  * Function output: a thread count between 1 and requested that leaves at
+  *                  least minItemsPerThread items to each thread
+  */
+    inline int resolveThreadCount(int requested, long long workItems, long long minItemsPerThread = 4096)
+    {
+      int threads = requested;
+      if(threads <= 0)
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+      if(threads <= 0)
+        threads = 1;
+      long long useful = workItems / minItemsPerThread;
+      if(useful < threads)
+        threads = useful < 1 ? 1 : static_cast<int>(useful);
+      return threads;
+    }
+    
+  /**
+  * Function: parallelFor
+  * Description: splits [begin, end) into one contiguous chunk per thread and
+  *              calls func(chunkBegin, chunkEnd, chunkNumber) on each. The
+  *              last chunk runs on the calling thread.
+  * Function input: the range, the number of threads and a callable
+  * Function output: none
+  * Postcondition: all chunks have been processed when the call returns
+  */
+    template<class Func>
+    void parallelFor(long long begin, long long end, int threads, Func func)
+    {
+      long long total = end - begin;
+      if(threads <= 1 || total <= 1)
+      {
+        func(begin, end, 0);
+        return;
+      }
+      if(total < threads)
+        threads = static_cast<int>(total);
+      
+      std::vector<std::thread> workers;
+      workers.reserve(threads - 1);
+      for(int t = 0; t < threads - 1; t++)
+      {
+        long long chunkBegin = begin + total * t / threads;
+        long long chunkEnd = begin + total * (t + 1) / threads;
+        workers.push_back(std::thread(func, chunkBegin, chunkEnd, t));
+      }
+      func(begin + total * (threads - 1) / threads, end, threads - 1);
+      for(size_t t = 0; t < workers.size(); t++)
+        workers[t].join();
+    }
+    
+  /**
+  * Function: parallelSort
+  * Description: sorts the items by sorting one chunk per thread and then
+  *              merging neighbouring chunks pairwise
+  * Function input: the items, a strict weak ordering and the number of threads
+  * Function output: none
+  * Postcondition: the items are sorted
+  */
+    template<class Item, class Compare>
+    void parallelSort(std::vector<Item>& items, Compare less, int threads)
+    {
+      long long total = static_cast<long long>(items.size());
+      if(threads <= 1 || total < 2 * threads)
+      {
+        std::sort(items.begin(), items.end(), less);
+        return;
+      }
+      
+      std::vector<long long> bounds(threads + 1);
+      for(int t = 0; t <= threads; t++)
+        bounds[t] = total * t / threads;
+      
+      parallelFor(0, threads, threads, [&](long long first, long long last, int)
+      {
+        for(long long t = first; t < last; t++)
+          std::sort(items.begin() + bounds[t], items.begin() + bounds[t + 1], less);
+      });
+      
+      for(int width = 1; width < threads; width *= 2)
+      {
+        int merges = (threads + 2 * width - 1) / (2 * width);
+        parallelFor(0, merges, merges, [&](long long first, long long last, int)
+        {
+          for(long long m = first; m < last; m++)
+          {
+            int low = static_cast<int>(m) * 2 * width;
+            int mid = std::min(low + width, threads);
+            int high = std::min(low + 2 * width, threads);
+            if(mid < high)
+              std::inplace_merge(items.begin() + bounds[low], items.begin() + bounds[mid],
+                                 items.begin() + bounds[high], less);
+          }
+        });
+      }
+    }
+
+  /**
+  * Function: mixHash64
+  * Description: scrambles a 64 bit value (the splitmix64 finalizer), nearby
+  *              inputs give unrelated outputs
+  * Function input: a value
+  * Function output: its hash
+  */
+    inline unsigned long long mixHash64(unsigned long long value)
+    {
+      value += 0x9e3779b97f4a7c15ULL;
+      value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+      return value ^ (value >> 31);
+    }
+
+  /**
+  * Description: The interned keys of a graph: an open addressing table of
+  * handle ids, hashed and compared through the info column they index, so
+  * every key is stored once, in the column. Lookups only read the table.
+  */
+    template<class Type, class KeyHash>
+    class HandleTable
+    {
+    public:
+      static const unsigned int EMPTY = 0xffffffffu; // a free slot, and find's answer for a missing key
+      
+      HandleTable() : used(0) {}
+      
+      /**
+      * Function: find / insert / erase / clear
+      * Description: the id whose info equals a key (EMPTY if none), adding
+      *              an id whose info is in the column, removing an id while
+      *              its info is still in the column, and emptying the table
+      */
+      unsigned int find(const Type& vertex, const std::vector<Type>& payload) const;
+      void insert(unsigned int id, const std::vector<Type>& payload);
+      void erase(unsigned int id, const std::vector<Type>& payload);
+      void clear();
+      
+    private:
+      size_t home(const Type& vertex) const
+      {
+        return static_cast<size_t>(mixHash64(KeyHash()(vertex))) & (slots.size() - 1);
+      }
+      
+      std::vector<unsigned int> slots; // a power of two of them, at most 3/4 used
+      size_t used; // ids in the table
+    };
+    
+  template<class Type, class KeyHash>
+  const unsigned int HandleTable<Type, KeyHash>::EMPTY;
+    
+  template<class Type, class KeyHash>
+  unsigned int HandleTable<Type, KeyHash>::find(const Type& vertex, const std::vector<Type>& payload) const
+  {
+    if(slots.empty())
+      return EMPTY;
+    size_t mask = slots.size() - 1;
+    for(size_t i = home(vertex); slots[i] != EMPTY; i = (i + 1) & mask)
+    {
+      if(payload[slots[i]] == vertex)
+        return slots[i];
+    }
+    return EMPTY;
+  }
+    
+  template<class Type, class KeyHash>
+  void HandleTable<Type, KeyHash>::insert(unsigned int id, const std::vector<Type>& payload)
+  {
+    if(4 * (used + 1) > 3 * slots.size())
+    {
+      std::vector<unsigned int> old(std::max<size_t>(16, 2 * slots.size()), EMPTY);
+      old.swap(slots);
+      used = 0;
+      for(size_t i = 0; i < old.size(); i++)
+      {
+        if(old[i] != EMPTY)
+          insert(old[i], payload);
+      }
+    }
+    size_t mask = slots.size() - 1;
+    size_t i = home(payload[id]);
+    while(slots[i] != EMPTY)
+      i = (i + 1) & mask;
+    slots[i] = id;
+    used++;
+  }
+    
+  template<class Type, class KeyHash>
+  void HandleTable<Type, KeyHash>::erase(unsigned int id, const std::vector<Type>& payload)
+  {
+    if(slots.empty())
+      return;
+    size_t mask = slots.size() - 1;
+    size_t hole = home(payload[id]);
+    while(slots[hole] != id)
+    {
+      if(slots[hole] == EMPTY)
+        return;
+      hole = (hole + 1) & mask;
+    }
+    // shift back the ids after the hole that may live in it, so no probe
+    // sequence is cut short
+    for(size_t j = (hole + 1) & mask; slots[j] != EMPTY; j = (j + 1) & mask)
+    {
+      size_t wanted = home(payload[slots[j]]);
+      if(((j - wanted) & mask) >= ((j - hole) & mask))
+      {
+        slots[hole] = slots[j];
+        hole = j;
+      }
+    }
+    slots[hole] = EMPTY;
+    used--;
+  }
+    
+  template<class Type, class KeyHash>
+  void HandleTable<Type, KeyHash>::clear()
+  {
+    slots.clear();
+    used = 0;
+  }
+    
+    template<class Type, class KeyHash = VertexKeyHash<Type> >
     class Graph
     {
     public:
@@ -101,12 +503,12 @@ namespace GraphNameSpace
     /**
       * the copy constructor
       */
-      Graph(const Graph<Type>& otherGraph);
+      Graph(const Graph& otherGraph);
       
       /**
       * overloading the assignment operator
       */
-      const Graph& operator=(const Graph<Type>& arg);
+      const Graph& operator=(const Graph& arg);
       
     /**
       * Function: ~Graph -The destructor
@@ -157,6 +559,7 @@ namespace GraphNameSpace
       * Postcondition: returns true if adjancency exist or false otherwise
       */
       bool isAdjacentTo(const Type&,const Type&) const throw (std::logic_error);
+      bool isAdjacentTo(VertexHandle, VertexHandle) const throw (std::logic_error);
 
     /**
       * Function: edgeWeight
@@ -167,6 +570,7 @@ namespace GraphNameSpace
       * Postcondition: the weight of the edge is returned
       */
       int edgeWeight(const Type&,const Type&) const throw (std::logic_error);// precondition: edge exists
+      int edgeWeight(VertexHandle, VertexHandle) const throw (std::logic_error);
       
       /**
       * Function: edgeWeight
@@ -188,15 +592,40 @@ namespace GraphNameSpace
       */
       int vertexCount() const;
       
+      /**
+      * Function: positionCount
+      * Description: returns one past the last vertex position. Generic
+      *              algorithms size their per-vertex arrays with it; on a
+      *              Graph it equals vertexCount(), on a FilteredView or a
+      *              TemporalSnapshot it also counts the positions left out.
+      * Function input: none
+      * Function output: the number of positions
+      * Precondition: none
+      * Postcondition: the number of positions is returned
+      */
+      int positionCount() const;
+      
+      /**
+      * Function: containsVertex
+      * Description: checks if a position holds a vertex. Generic algorithms
+      *              use it to skip the positions a FilteredView leaves out.
+      * Function input: a vertex position
+      * Function output: None.
+      * Precondition: none
+      * Postcondition: returns true if 0 <= position < vertexCount()
+      */
+      bool containsVertex(int vertexIndex) const;
+      
       /**
       * Function: insertVertex
       * Description: inserts a vertex in the graph
       * Function input: a vertex
-      * Function output: none
+      * Function output: the handle of the new vertex, NO_VERTEX if it
+      *                  already existed
       * Precondition: a graph should exist
       * Postcondition: a vertex is inserted to the graph
       */
-      void insertVertex(const Type&) throw (std::range_error, std::logic_error);
+      VertexHandle insertVertex(const Type&) throw (std::range_error, std::logic_error);
       
       /**
       * Function: insertEdge
@@ -207,6 +636,7 @@ namespace GraphNameSpace
       * Postcondition: a edge is inserted betwen tow vertices
       */
       void insertEdge(const Type&,const Type&, int weight=1);
+      void insertEdge(VertexHandle, VertexHandle, int weight=1);
       
       /**
       * Function: deleteEdge
@@ -217,6 +647,7 @@ namespace GraphNameSpace
       * Postcondition: the edge is deleted betwen the two vertices
       */
       void deleteEdge(const Type&,const Type&) throw (std::logic_error);
+      void deleteEdge(VertexHandle, VertexHandle) throw (std::logic_error);
       
     /**
       * Function: deleteVertex
@@ -227,6 +658,7 @@ namespace GraphNameSpace
       * Postcondition: the vertex is deleted
       */
       void deleteVertex(const Type&) throw (std::logic_error);
+      void deleteVertex(VertexHandle) throw (std::logic_error);
       
     /**
       * Function: findVertex
@@ -238,9 +670,51 @@ namespace GraphNameSpace
       */
       int findVertex(const Type& vertex) const;
       
+    /**
+      * Function: handleOf
+      * Description: looks up the handle of a vertex in the interned keys
+      * Function input: a vertex
+      * Function output: its handle, NO_VERTEX if it doesn't exist
+      * Precondition: none
+      * Postcondition: the handle is returned
+      */
+      VertexHandle handleOf(const Type& vertex) const;
+      
+    /**
+      * Function: handleAt
+      * Description: returns the handle of the vertex at a position
+      * Function input: the position of the vertex
+      * Function output: its handle
+      * Precondition: 0 <= position < vertexCount()
+      * Postcondition: the handle is returned
+      */
+      VertexHandle handleAt(int vertexIndex) const;
+      
+    /**
+      * Function: positionOf
+      * Description: returns the current position of a vertex
+      * Function input: a vertex handle
+      * Function output: its position, -1 if the handle isn't in the graph
+      * Precondition: none
+      * Postcondition: the position is returned
+      */
+      int positionOf(VertexHandle vertex) const;
+      
+    /**
+      * Function: info
+      * Description: returns the info held by a vertex
+      * Function input: a vertex handle
+      * Function output: the info of the vertex
+      * Precondition: the handle should be in the graph
+      * Postcondition: the info is returned, a default constructed Type if
+      *                the handle isn't in the graph
+      */
+      const Type& info(VertexHandle vertex) const throw (std::logic_error);
+      
     /**
       * Function: dump
-      * Description: prints the whle graph
+      * Description: prints the whle graph for debugging, use GraphWriter
+      *              from graph_export.h to export large graphs
       * Function input: none
       * Function output: none
       * Precondition: a ghraph object should exist
@@ -248,67 +722,345 @@ namespace GraphNameSpace
       */
       void dump() const;
       
+    /**
+      * Function: neighbors
+      * Description: gives read-only access to the adjacency list of a vertex
+      * Function input: a vertex
+      * Function output: a range of (connIndex, edgeWeight) pairs
+      * Precondition: the vertex should exist
+      * Postcondition: the range is valid until the graph is next modified,
+      *                an empty range is returned if the vertex doesn't exist
+      */
+      AdjacencyRange<Type> neighbors(const Type&) const throw (std::logic_error);
+      AdjacencyRange<Type> neighbors(VertexHandle) const throw (std::logic_error);
+      
+    /**
+      * Function: neighborsAt
+      * Description: gives read-only access to the adjacency list of the
+      *              vertex stored at a position in the graph
+      * Function input: the position of the vertex
+      * Function output: a range of (connIndex, edgeWeight) pairs
+      * Precondition: 0 <= position < vertexCount()
+      * Postcondition: the range is valid until the graph is next modified
+      */
+      AdjacencyRange<Type> neighborsAt(int vertexIndex) const;
+      
+    /**
+      * Function: infoAt
+      * Description: returns the info held by the vertex at a position
+      * Function input: the position of the vertex
+      * Function output: the info of the vertex
+      * Precondition: 0 <= position < vertexCount()
+      * Postcondition: the info is returned
+      */
+      const Type& infoAt(int vertexIndex) const;
+      
+    /**
+      * Function: forEachVertex
+      * Description: calls func(vertexIndex, info) for every vertex
+      * Function input: a callable
+      * Function output: none
+      * Precondition: func must not modify the graph
+      * Postcondition: func has been called once per vertex in position order
+      */
+      template<class Func>
+      void forEachVertex(Func func) const;
+      
+    /**
+      * Function: forEachNeighbor
+      * Description: calls func(connIndex, edgeWeight) for every entry in the
+      *              adjacency list of the vertex at a position
+      * Function input: the position of the vertex and a callable
+      * Function output: none
+      * Precondition: 0 <= position < vertexCount(), func must not modify the graph
+      * Postcondition: func has been called once per adjacency entry
+      */
+      template<class Func>
+      void forEachNeighbor(int vertexIndex, Func func) const;
+      
+    /**
+      * Function: forEachEdge
+      * Description: calls func(fromIndex, toIndex, edgeWeight) for every
+      *              entry of every adjacency list. An undirected edge is
+      *              stored on both of its vertices and so is visited twice,
+      *              once from each end.
+      * Function input: a callable
+      * Function output: none
+      * Precondition: func must not modify the graph
+      * Postcondition: func has been called once per adjacency entry
+      */
+      template<class Func>
+      void forEachEdge(Func func) const;
+      
+    /**
+      * Function: minimumSpanningForest
+      * Description: computes a minimum spanning tree of every connected
+      *              component, either with Kruskal (parallel sort of the edges
+      *              followed by union-find) or with parallel Boruvka
+      * Function input: the algorithm and the number of threads (0 for all cores)
+      * Function output: the chosen edges and their total weight
+      * Precondition: the graph should be WEIGHTED and UNDIRECTED
+      * Postcondition: the forest is returned, or an empty forest if the
+      *                graph is not weighted and undirected
+      */
+      SpanningForest minimumSpanningForest(SpanningAlgorithm algorithm = KRUSKAL, int threads = 0) const throw (std::logic_error);
+      
+    /**
+      * Function: topologicalSort
+      * Description: orders the vertices so that every edge goes forward,
+      *              using a parallel Kahn's algorithm that emits one frontier
+      *              of zero in-degree vertices per batch
+      * Function input: the number of threads (0 for all cores)
+      * Function output: the order, per-vertex positions and levels, and a
+      *                  cycle if one exists
+      * Precondition: the graph should be DIRECTED
+      * Postcondition: the order is returned, or an empty result if the graph
+      *                is undirected
+      */
+      TopologicalOrder topologicalSort(int threads = 0) const throw (std::logic_error);
+      
+    /**
+      * Function: criticalPaths
+      * Description: computes the longest weighted path ending at every vertex
+      *              and starting at any source of the DAG. An UNWEIGHTED
+      *              graph counts every edge as 1.
+      * Function input: the number of threads (0 for all cores)
+      * Function output: the path lengths and predecessors
+      * Precondition: the graph should be DIRECTED and acyclic
+      * Postcondition: the paths are returned, acyclic is false if the graph
+      *                has a cycle
+      */
+      DagPaths criticalPaths(int threads = 0) const throw (std::logic_error);
+      
+    /**
+      * Function: longestPathsFrom
+      * Description: computes the longest weighted path from a vertex to every
+      *              vertex of the DAG
+      * Function input: the start vertex and the number of threads
+      * Function output: the path lengths and predecessors
+      * Precondition: the graph should be DIRECTED and acyclic, the vertex should exist
+      * Postcondition: the paths are returned, acyclic is false if the graph
+      *                has a cycle
+      */
+      DagPaths longestPathsFrom(const Type&, int threads = 0) const throw (std::logic_error);
+      DagPaths longestPathsFrom(VertexHandle, int threads = 0) const throw (std::logic_error);
+      
+    /**
+      * Function: shortestPathsFrom
+      * Description: computes the shortest weighted path from a vertex to
+      *              every vertex of the DAG, negative weights are allowed
+      * Function input: the start vertex and the number of threads
+      * Function output: the path lengths and predecessors
+      * Precondition: the graph should be DIRECTED and acyclic, the vertex should exist
+      * Postcondition: the paths are returned, acyclic is false if the graph
+      *                has a cycle
+      */
+      DagPaths shortestPathsFrom(const Type&, int threads = 0) const throw (std::logic_error);
+      DagPaths shortestPathsFrom(VertexHandle, int threads = 0) const throw (std::logic_error);
+      
+    /**
+      * Function: connected
+      * Description: checks if two vertices are in the same connected
+      *              component, ignoring edge directions. The first call turns
+      *              on an index that insertVertex and insertEdge keep up to
+      *              date; deletions mark it dirty and the next query rebuilds
+      *              it once, however many deletions came before.
+      *              connected and reachable may be called from several
+      *              threads at once: a rebuild is done by one of them under
+      *              a lock, and queries on a built index only read it. They
+      *              must not run at the same time as changes to the graph.
+      * Function input: two vertices
+      * Function output: None.
+      * Precondition: the vertices should exist
+      * Postcondition: returns true if they are connected or false otherwise
+      */
+      bool connected(const Type&, const Type&) const throw (std::logic_error);
+      bool connected(VertexHandle, VertexHandle) const throw (std::logic_error);
+      
+    /**
+      * Function: reachable
+      * Description: checks if there is a path following edge directions from
+      *              the first vertex to the second. On DIRECTED graphs this is
+      *              answered from a bitset transitive closure that is updated
+      *              in place on insertEdge and rebuilt lazily after deletions.
+      * Function input: two vertices
+      * Function output: None.
+      * Precondition: the vertices should exist
+      * Postcondition: returns true if a path exists or false otherwise
+      */
+      bool reachable(const Type&, const Type&) const throw (std::logic_error);
+      bool reachable(VertexHandle, VertexHandle) const throw (std::logic_error);
+      
+    /**
+      * Function: dropConnectivityIndex
+      * Description: stops maintaining the connectivity index and frees it
+      * Function input: none
+      * Function output: None.
+      * Precondition: none
+      * Postcondition: the next connected or reachable call rebuilds the index
+      */
+      void dropConnectivityIndex();
+      
+    /**
+      * Function: buildConnectivityIndex
+      * Description: turns on and builds the connectivity index (and the
+      *              reachability closure if asked) ahead of the first query,
+      *              so reader threads started afterwards never wait on a build
+      * Function input: whether to build the reachability closure too
+      * Function output: None.
+      * Precondition: none
+      * Postcondition: the index is up to date
+      */
+      void buildConnectivityIndex(bool withReachability = false) const;
+      
+    /**
+      * Function: inducedSubgraph
+      * Description: builds a compact graph holding the given vertices and
+      *              the edges among them that pass the filter. Each thread
+      *              copies the adjacency lists of its own slice of vertices.
+      * Function input: the positions of the vertices to keep, in the order
+      *                 they should be stored, an edge filter and the number
+      *                 of threads (0 for all cores)
+      * Function output: the new graph
+      * Precondition: the positions should exist, duplicates are ignored
+      * Postcondition: the new graph has the same weight and direction, and
+      *                vertex i of it is the i-th distinct position passed
+      */
+      Graph inducedSubgraph(const std::vector<int>& vertexIndices, int threads = 0) const;
+      
+      template<class EdgeFilter>
+      Graph inducedSubgraph(const std::vector<int>& vertexIndices, EdgeFilter keepEdge, int threads = 0) const;
+      
       Weight weigh;  // is graph weighted?
       Direction direction; // is the graph directed?
       int edgeCountNum; // the numbr of edges in the graph
       int count; // the number of vertices in the graph
 
     private:
-      Vertex<Type> *node;  // the collection of vertices in the graph
+      /**
+      * Function: noteVertexInserted / noteEdgeInserted
+      * Description: keep the connectivity index in step with an insertion,
+      *              or leave it dirty for the next query to rebuild
+      */
+      void noteVertexInserted();
+      void noteEdgeInserted(int indexFrom, int indexTo);
+      
+      /**
+      * Function: refreshConnectivity
+      * Description: rebuilds whatever part of the connectivity index is
+      *              dirty, in one pass over all edges
+      */
+      void refreshConnectivity(bool needReachability) const;
+      
+      /**
+      * Function: initStorage
+      * Description: sizes the topology arrays for an empty graph
+      */
+      void initStorage();
+      
+      /**
+      * Function: rowAt
+      * Description: returns the adjacency list of the vertex at a position
+      */
+      ConnectedVertices<Type>* rowAt(int vertexIndex);
+      const ConnectedVertices<Type>* rowAt(int vertexIndex) const;
+      
+      /**
+      * Function: findEdgeAt / edgeWeightAt / insertEdgeAt / deleteEdgeAt /
+      *           removeEntry / deleteVertexAt / connectedAt / reachableAt /
+      *           pathsFromAt
+      * Description: the operations on vertex positions that the key and
+      *              handle versions share once they have looked the
+      *              vertices up
+      */
+      int findEdgeAt(int indexFrom, int indexTo) const;
+      int edgeWeightAt(int indexFrom, int indexTo) const;
+      bool connectedAt(int indexFrom, int indexTo) const;
+      bool reachableAt(int indexFrom, int indexTo) const;
+      DagPaths pathsFromAt(int sourceIndex, bool longest, int threads) const;
+      void insertEdgeAt(int indexFrom, int indexTo, int weight);
+      void deleteEdgeAt(int indexFrom, int indexTo);
+      void removeEntry(int vertexIndex, int slot);
+      void deleteVertexAt(int vertexIndex);
+      
+      // topology, indexed by position
+      std::vector<int> countAdj; // number of adjacent vertices of each vertex
+      std::vector<ConnectedVertices<Type> > adjacency; // MAX_ADJACENT entries per position
+      std::vector<VertexHandle> handleOfPosition; // handle of the vertex at each position
+      
+      // info, indexed by handle
+      std::vector<Type> payload; // info held by each vertex, never moved by deletions
+      std::vector<int> positionOfHandle; // position of each handle, -1 if it is free
+      std::vector<unsigned int> generationOfHandle; // current generation of each slot
+      std::vector<unsigned int> freeHandles; // handles of deleted vertices
+      HandleTable<Type, KeyHash> handleOfKey; // interned keys, the ids of payload by its values
+      
+      // the flags are atomic so queries can check them without the lock
+      mutable std::atomic<bool> connectivityEnabled; // is the connectivity index maintained?
+      mutable std::atomic<bool> connectivityDirty; // has a deletion invalidated the index?
+      mutable DisjointSet connectivity; // weakly connected components
+      mutable std::atomic<bool> reachabilityBuilt; // has the reachability closure been built?
+      mutable std::vector<std::vector<unsigned long long> > reachability; // bit j of row i: i reaches j
+      mutable std::mutex connectivityLock; // held while the index is rebuilt
     };
     
-    template<class Type>
-    Graph<Type>::Graph()
+    template<class Type, class KeyHash>
+    Graph<Type, KeyHash>::Graph()
     {
       weigh = UNWEIGHTED;
       direction = UNDIRECTED;
-      node = new Vertex<Type>[100];
-      count = 0;
-      edgeCountNum=0;
+      initStorage();
+      connectivityEnabled = false;
+      connectivityDirty = true;
+      reachabilityBuilt = false;
     }
     
-    template<class Type>
-    Graph<Type>::Graph(Direction dir, Weight weight)
+    template<class Type, class KeyHash>
+    Graph<Type, KeyHash>::Graph(Direction dir, Weight weight)
     {
       weigh = weight;
       direction = dir;
-      node = new Vertex<Type>[100];
-      count = 0;
-      edgeCountNum=0;
+      initStorage();
+      connectivityEnabled = false;
+      connectivityDirty = true;
+      reachabilityBuilt = false;
     }
     
-    template<class Type>
-    Graph<Type>::Graph(Weight weight, Direction dir)
+    template<class Type, class KeyHash>
+    Graph<Type, KeyHash>::Graph(Weight weight, Direction dir)
     {
       weigh = weight;
       direction = dir;
-      node = new Vertex<Type>[100];
-      count = 0;
-      edgeCountNum=0;
+      initStorage();
+      connectivityEnabled = false;
+      connectivityDirty = true;
+      reachabilityBuilt = false;
     }
     
-    template<class Type>
-    Graph<Type>::Graph(Direction dir)
+    template<class Type, class KeyHash>
+    Graph<Type, KeyHash>::Graph(Direction dir)
     {
       weigh = UNWEIGHTED;
       direction = dir;
-      node = new Vertex<Type>[100];
-      count = 0;
-      edgeCountNum=0;
+      initStorage();
+      connectivityEnabled = false;
+      connectivityDirty = true;
+      reachabilityBuilt = false;
     }
     
-    template<class Type>
-    Graph<Type>::Graph(Weight weight)
+    template<class Type, class KeyHash>
+    Graph<Type, KeyHash>::Graph(Weight weight)
     {
       weigh = weight;
       direction = UNDIRECTED;
-      node = new Vertex<Type>[100];
-      count = 0;
-      edgeCountNum=0;
+      initStorage();
+      connectivityEnabled = false;
+      connectivityDirty = true;
+      reachabilityBuilt = false;
     }
     
-  template<class Type>
-  bool Graph<Type>::isEmpty() const
+  template<class Type, class KeyHash>
+  bool Graph<Type, KeyHash>::isEmpty() const
   {
     if(count == 0)
     {
@@ -320,10 +1072,10 @@ namespace GraphNameSpace
     }
   }
     
-  template<class Type>
-  bool Graph<Type>::isFull() const
+  template<class Type, class KeyHash>
+  bool Graph<Type, KeyHash>::isFull() const
   {
-    if(count == 100)
+    if(count == MAX_VERTICES)
     {
       return true;
     }
@@ -333,190 +1085,147 @@ namespace GraphNameSpace
     }
   }
     
-  template<class Type>
-  void Graph<Type>::insertVertex(const Type& itemToInsert) throw (std::range_error, std::logic_error)
+  template<class Type, class KeyHash>
+  void Graph<Type, KeyHash>::initStorage()
   {
-    try
-    {
+    countAdj.assign(MAX_VERTICES, 0);
+    adjacency.assign(MAX_VERTICES * MAX_ADJACENT, ConnectedVertices<Type>());
+    handleOfPosition.assign(MAX_VERTICES, NO_VERTEX);
+    payload.clear();
+    positionOfHandle.clear();
+    generationOfHandle.clear();
+    freeHandles.clear();
+    handleOfKey.clear();
+    count = 0;
+    edgeCountNum = 0;
+  }
+    
+  template<class Type, class KeyHash>
+  inline ConnectedVertices<Type>* Graph<Type, KeyHash>::rowAt(int vertexIndex)
+  {
+    return &adjacency[vertexIndex * MAX_ADJACENT];
+  }
+    
+  template<class Type, class KeyHash>
+  inline const ConnectedVertices<Type>* Graph<Type, KeyHash>::rowAt(int vertexIndex) const
+  {
+    return &adjacency[vertexIndex * MAX_ADJACENT];
+  }
+    
+  template<class Type, class KeyHash>
+  VertexHandle Graph<Type, KeyHash>::insertVertex(const Type& itemToInsert) throw (std::range_error, std::logic_error)
+  {
+    VertexHandle handle = NO_VERTEX;
+    try
+    {
       if(isFull() == true)
 	throw std::range_error("Graph is full");
       
-      int vertexIndexNumDelete;
-      bool vertex_exists = false;
-      
-      int edgeWeightNum;
-      
-      int deleteIndex;
-
-      for(int i=0; i< count; i++)
-      {
-	if(vertex_exists == false)
-	{
-	  if(node[i].info == itemToInsert)
-	  {
-	    vertex_exists = true;
-	    vertexIndexNumDelete = i;
-	  }
-	}
-      }
-      if(vertex_exists == true)
+      if(handleOfKey.find(itemToInsert, payload) != HandleTable<Type, KeyHash>::EMPTY)
 	throw std::logic_error("Item already exists in the Graph and will not be inserted");
       
-      node[count].info = itemToInsert;
-      node[count].vertexIndex = count;
-      node[count].countAdj = 0;
+      if(freeHandles.empty())
+      {
+        handle.id = static_cast<unsigned int>(payload.size());
+        handle.generation = 0;
+        payload.push_back(itemToInsert);
+        positionOfHandle.push_back(count);
+        generationOfHandle.push_back(0);
+      }
+      else
+      {
+        handle.id = freeHandles.back();
+        handle.generation = generationOfHandle[handle.id];
+        freeHandles.pop_back();
+        payload[handle.id] = itemToInsert;
+        positionOfHandle[handle.id] = count;
+      }
+      handleOfKey.insert(handle.id, payload);
+      handleOfPosition[count] = handle;
+      countAdj[count] = 0;
       count += 1;
+      noteVertexInserted();
     }
-    catch(const std::out_of_range bad_range)
+    catch(const std::range_error bad_range)
     {
-      cerr << "out_of_range: " << bad_range.what() << '\n';
+      cerr << "range_error: " << bad_range.what() << '\n';
     }
     catch(const std::logic_error item_exists)
     {
       cerr << "logic_error: " << item_exists.what() << '\n';
     }
+    return handle;
   }
     
-  template<class Type>
-  void Graph<Type>::insertEdge(const Type& fromVertex, const Type& toVertex, int weight)
-  {    
-    if(weigh == 0 && direction == 0) // if(weigh == WEIGHTED && direction == DIRECTED)
-    {
-      int indexFrom;
-      int indexTo;
-      
-      bool from_exists = false;
-      bool to_exists = false;
-      
-	for(int i=0; i< count; i++)
-	{
-	  if(from_exists == false)
-	  {
-	    if(node[i].info == fromVertex)
-	    {
-	      from_exists = true;
-	      indexFrom = i;
-	    }
-	  }
-	  if(to_exists == false)
-	  {
-	    if(node[i].info == toVertex)
-	    {
-	      to_exists = true; 
-	      indexTo = i;
-	    }
-	  }
-      }
-      node[indexFrom].edge[node[indexFrom].countAdj].connIndex = indexTo;
-      node[indexFrom].edge[node[indexFrom].countAdj].edgeWeight = weight;
-      node[indexFrom].countAdj++;
-    }
-    else if(weigh == 1 && direction == 1) // if(weigh == UNWEIGHTED && direction == UNDIRECTED)
-    {
-      int indexFrom;
-      int indexTo;
-      
-      bool from_exists = false;
-      bool to_exists = false;
-      
-	for(int i=0; i< count; i++)
-	{
-	  if(from_exists == false)
-	  {
-	    if(node[i].info == fromVertex)
-	    {
-	      from_exists = true;
-	      indexFrom = i;
-	    }
-	  }
-	  if(to_exists == false)
-	  {
-	    if(node[i].info == toVertex)
-	    {
-	      to_exists = true; 
-	      indexTo = i;
-	    }
-	  }
-      }
-      node[indexFrom].edge[node[indexFrom].countAdj].connIndex = indexTo;
-      node[indexFrom].edge[node[indexFrom].countAdj].edgeWeight = 0;
-      node[indexFrom].countAdj++;
-      
-      node[indexTo].edge[node[indexTo].countAdj].connIndex = indexFrom;
-      node[indexTo].edge[node[indexTo].countAdj].edgeWeight = 0;
-      node[indexTo].countAdj++;
-    }
-    else if(weigh == 1 && direction == 0) // if(weigh == UNWEIGHTED && direction == DIRECTED)
-    {
-      int indexFrom;
-      int indexTo;
-      
-      bool from_exists = false;
-      bool to_exists = false;
-      
-	for(int i=0; i< count; i++)
-	{
-	  if(from_exists == false)
-	  {
-	    if(node[i].info == fromVertex)
-	    {
-	      from_exists = true;
-	      indexFrom = i;
-	    }
-	  }
-	  if(to_exists == false)
-	  {
-	    if(node[i].info == toVertex)
-	    {
-	      to_exists = true; 
-	      indexTo = i;
-	    }
-	  }
-      }
-      node[indexFrom].edge[node[indexFrom].countAdj].connIndex = indexTo;
-      node[indexFrom].edge[node[indexFrom].countAdj].edgeWeight = 0;
-      node[indexFrom].countAdj++;
-    }
-    else if(weigh == 0 && direction == 1) // if(weigh == WEIGHTED && direction == UNDIRECTED)
-    {
-      int indexFrom;
-      int indexTo;
-      
-      bool from_exists = false;
-      bool to_exists = false;
-      
-	for(int i=0; i< count; i++)
-	{
-	  if(from_exists == false)
-	  {
-	    if(node[i].info == fromVertex)
-	    {
-	      from_exists = true;
-	      indexFrom = i;
-	    }
-	  }
-	  if(to_exists == false)
-	  {
-	    if(node[i].info == toVertex)
-	    {
-	      to_exists = true; 
-	      indexTo = i;
-	    }
-	  }
-      }
-      node[indexFrom].edge[node[indexFrom].countAdj].connIndex = indexTo;
-      node[indexFrom].edge[node[indexFrom].countAdj].edgeWeight = weight;
-      node[indexFrom].countAdj++;
-      
-      node[indexTo].edge[node[indexTo].countAdj].connIndex = indexFrom;
-      node[indexTo].edge[node[indexTo].countAdj].edgeWeight = weight;
-      node[indexTo].countAdj++;
+  template<class Type, class KeyHash>
+  void Graph<Type, KeyHash>::insertEdge(const Type& fromVertex, const Type& toVertex, int weight)
+  {
+    int indexFrom = findVertex(fromVertex);
+    int indexTo = findVertex(toVertex);
+    try
+    {
+      if(indexFrom == -1 || indexTo == -1)
+        throw std::logic_error("Either or both of the vertices don't exist in the graph. Couldn't insert the edge");
     }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return;
+    }
+    insertEdgeAt(indexFrom, indexTo, weight);
+  }
+    
+  template<class Type, class KeyHash>
+  void Graph<Type, KeyHash>::insertEdge(VertexHandle fromVertex, VertexHandle toVertex, int weight)
+  {
+    int indexFrom = positionOf(fromVertex);
+    int indexTo = positionOf(toVertex);
+    try
+    {
+      if(indexFrom == -1 || indexTo == -1)
+        throw std::logic_error("Either or both of the vertex handles are not in the graph. Couldn't insert the edge");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return;
+    }
+    insertEdgeAt(indexFrom, indexTo, weight);
+  }
+    
+  template<class Type, class KeyHash>
+  void Graph<Type, KeyHash>::insertEdgeAt(int indexFrom, int indexTo, int weight)
+  {
+    bool undirected = direction == UNDIRECTED;
+    try
+    {
+      // an undirected self loop takes two entries of the same list
+      int fromNeeds = (undirected && indexFrom == indexTo) ? 2 : 1;
+      if(countAdj[indexFrom] + fromNeeds > MAX_ADJACENT || (undirected && countAdj[indexTo] + 1 > MAX_ADJACENT))
+        throw std::range_error("Adjacency list is full. Couldn't insert the edge");
+    }
+    catch(const std::range_error full)
+    {
+      cerr << "range_error: " << full.what() << '\n';
+      return;
+    }
+    
+    int storedWeight = (weigh == WEIGHTED) ? weight : 0;
+    ConnectedVertices<Type>& forward = rowAt(indexFrom)[countAdj[indexFrom]++];
+    forward.connIndex = indexTo;
+    forward.edgeWeight = storedWeight;
+    if(undirected)
+    {
+      ConnectedVertices<Type>& backward = rowAt(indexTo)[countAdj[indexTo]++];
+      backward.connIndex = indexFrom;
+      backward.edgeWeight = storedWeight;
+    }
+    noteEdgeInserted(indexFrom, indexTo);
     edgeCountNum+=1;
   }
     
-  template<class Type>
-  void Graph<Type>::dump() const
+  template<class Type, class KeyHash>
+  void Graph<Type, KeyHash>::dump() const
   {
     string type;
     string weight;
@@ -527,415 +1236,1220 @@ namespace GraphNameSpace
       weight = "UNWEIGHTED";
     
     if(direction == 0)
-      weight = "DIRECTED";
+      type = "DIRECTED";
     else
-      weight = "UNDIRECTED";
+      type = "UNDIRECTED";
 //     
-    cout << "dumping graph: " << type << "   " << weight  << "    vertices:" << vertexCount() << "    edges:" << edgeCount() << endl;
-    cout << left << setw(25) <<  "VERTEX " << setw(50) << "ADJACENT VERTICES" << endl;
-    cout << left << setw(25) <<  "-----------------" << setw(50) << "---------------------------------------------------" << endl;
+    cout << "dumping graph: " << type << "   " << weight  << "    vertices:" << vertexCount() << "    edges:" << edgeCount() << '\n';
+    cout << left << setw(25) <<  "VERTEX " << setw(50) << "ADJACENT VERTICES" << '\n';
+    cout << left << setw(25) <<  "-----------------" << setw(50) << "---------------------------------------------------" << '\n';
     
 
     for(int i=0; i <count; i++)
     {
-      cout << setw(1) << "[" << setw(1) << i << setw(3) << "]"  << setw(17) << node[i].info;
-      for(int j = 0; j< node[i].countAdj; j++)
+      cout << setw(1) << "[" << setw(1) << i << setw(3) << "]"  << setw(17) << infoAt(i);
+      const ConnectedVertices<Type>* row = rowAt(i);
+      for(int j = 0; j< countAdj[i]; j++)
       {
-	cout << "[" << node[i].edge[j].connIndex << "]" << node[node[i].edge[j].connIndex].info << "(" << node[i].edge[j].edgeWeight << ")    ";
+	cout << "[" << row[j].connIndex << "]" << infoAt(row[j].connIndex) << "(" << row[j].edgeWeight << ")    ";
       }
-      cout << endl;
+      cout << '\n';
+    }
+    cout.flush();
+  }
+    
+  template<class Type, class KeyHash>
+  AdjacencyRange<Type> Graph<Type, KeyHash>::neighbors(const Type& vertex) const throw (std::logic_error)
+  {
+    int vertexIndex = findVertex(vertex);
+    try
+    {
+      if(vertexIndex == -1)
+        throw std::logic_error("Vertex doesn't exist in the graph. No neighbors to return");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return AdjacencyRange<Type>(0, 0);
     }
+    return neighborsAt(vertexIndex);
   }
     
-  template<class Type>
-  bool Graph<Type>::isAdjacentTo(const Type& fromVertex, const Type& toVertex) const throw (std::logic_error)
+  template<class Type, class KeyHash>
+  AdjacencyRange<Type> Graph<Type, KeyHash>::neighbors(VertexHandle vertex) const throw (std::logic_error)
   {
-    int indexFrom;
-    int indexTo;
+    int vertexIndex = positionOf(vertex);
+    try
+    {
+      if(vertexIndex == -1)
+        throw std::logic_error("Vertex handle is not in the graph. No neighbors to return");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return AdjacencyRange<Type>(0, 0);
+    }
+    return neighborsAt(vertexIndex);
+  }
     
-    bool isAdjacent = false;
+  template<class Type, class KeyHash>
+  inline AdjacencyRange<Type> Graph<Type, KeyHash>::neighborsAt(int vertexIndex) const
+  {
+    const ConnectedVertices<Type>* first = rowAt(vertexIndex);
+    return AdjacencyRange<Type>(first, first + countAdj[vertexIndex]);
+  }
     
-    bool from_exists = false;
-    bool to_exists = false;
-
-    for(int i=0; i< count; i++)
-      {
-	if(from_exists == false)
-	{
-	  if(node[i].info == fromVertex)
-	  {
-	    from_exists = true;
-	    indexFrom = i;
-	  }
-	}
-	if(to_exists == false)
-	{
-	  if(node[i].info == toVertex)
-	  {
-	    to_exists = true; 
-	    indexTo = i;
-	  }
-	}
-      }
-
-      try
-      {
-      if((from_exists == false) || to_exists == false )
-	throw std::logic_error("Either or both of the vertices don't exist in the graph. Cannot check adjacency");
-      
-	for(int i=0; i< node[indexFrom].countAdj; i++)
-	{
-	  if(indexTo == node[indexFrom].edge[i].connIndex) 
-	  {
-	    isAdjacent = true;
-	    break;
-	  }
-	}
-      }
-      catch(const std::logic_error bad_item)
+  template<class Type, class KeyHash>
+  inline const Type& Graph<Type, KeyHash>::infoAt(int vertexIndex) const
+  {
+    return payload[handleOfPosition[vertexIndex].id];
+  }
+    
+  template<class Type, class KeyHash>
+  inline const Type& Graph<Type, KeyHash>::info(VertexHandle vertex) const throw (std::logic_error)
+  {
+    try
+    {
+      if(positionOf(vertex) == -1)
+        throw std::logic_error("Vertex handle is not in the graph. No info to return");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      static const Type missing = Type();
+      return missing;
+    }
+    return payload[vertex.id];
+  }
+    
+  template<class Type, class KeyHash>
+  inline VertexHandle Graph<Type, KeyHash>::handleOf(const Type& vertex) const
+  {
+    unsigned int found = handleOfKey.find(vertex, payload);
+    if(found == HandleTable<Type, KeyHash>::EMPTY)
+      return NO_VERTEX;
+    VertexHandle handle = {found, generationOfHandle[found]};
+    return handle;
+  }
+    
+  template<class Type, class KeyHash>
+  inline VertexHandle Graph<Type, KeyHash>::handleAt(int vertexIndex) const
+  {
+    return handleOfPosition[vertexIndex];
+  }
+    
+  template<class Type, class KeyHash>
+  inline int Graph<Type, KeyHash>::positionOf(VertexHandle vertex) const
+  {
+    if(vertex.id >= positionOfHandle.size() || vertex.generation != generationOfHandle[vertex.id])
+      return -1;
+    return positionOfHandle[vertex.id];
+  }
+    
+  template<class Type, class KeyHash>
+  template<class Func>
+  inline void Graph<Type, KeyHash>::forEachVertex(Func func) const
+  {
+    for(int i = 0; i < count; i++)
+    {
+      func(i, infoAt(i));
+    }
+  }
+    
+  template<class Type, class KeyHash>
+  template<class Func>
+  inline void Graph<Type, KeyHash>::forEachNeighbor(int vertexIndex, Func func) const
+  {
+    const ConnectedVertices<Type>* row = rowAt(vertexIndex);
+    for(int j = 0; j < countAdj[vertexIndex]; j++)
+    {
+      func(row[j].connIndex, row[j].edgeWeight);
+    }
+  }
+    
+  template<class Type, class KeyHash>
+  template<class Func>
+  inline void Graph<Type, KeyHash>::forEachEdge(Func func) const
+  {
+    for(int i = 0; i < count; i++)
+    {
+      const ConnectedVertices<Type>* row = rowAt(i);
+      for(int j = 0; j < countAdj[i]; j++)
       {
-	cerr << "logic_error: " << bad_item.what() << '\n';
+        func(i, row[j].connIndex, row[j].edgeWeight);
       }
-      return isAdjacent;
+    }
+  }
+    
+  template<class Type, class KeyHash>
+  int Graph<Type, KeyHash>::findEdgeAt(int indexFrom, int indexTo) const
+  {
+    const ConnectedVertices<Type>* row = rowAt(indexFrom);
+    for(int j = 0; j < countAdj[indexFrom]; j++)
+    {
+      if(row[j].connIndex == indexTo)
+        return j;
+    }
+    return -1;
+  }
+    
+  template<class Type, class KeyHash>
+  bool Graph<Type, KeyHash>::isAdjacentTo(const Type& fromVertex, const Type& toVertex) const throw (std::logic_error)
+  {
+    int indexFrom = findVertex(fromVertex);
+    int indexTo = findVertex(toVertex);
+    try
+    {
+      if((indexFrom == -1) || indexTo == -1)
+	throw std::logic_error("Either or both of the vertices don't exist in the graph. Cannot check adjacency");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return false;
+    }
+    return findEdgeAt(indexFrom, indexTo) != -1;
+  }
+    
+  template<class Type, class KeyHash>
+  bool Graph<Type, KeyHash>::isAdjacentTo(VertexHandle fromVertex, VertexHandle toVertex) const throw (std::logic_error)
+  {
+    int indexFrom = positionOf(fromVertex);
+    int indexTo = positionOf(toVertex);
+    try
+    {
+      if((indexFrom == -1) || indexTo == -1)
+	throw std::logic_error("Either or both of the vertex handles are not in the graph. Cannot check adjacency");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return false;
+    }
+    return findEdgeAt(indexFrom, indexTo) != -1;
   }
 
-  template<class Type>
-  int Graph<Type>::vertexCount() const
+  template<class Type, class KeyHash>
+  int Graph<Type, KeyHash>::vertexCount() const
   {
     return  count;
   }
   
-  template<class Type>
-  int Graph<Type>::edgeCount() const
+  template<class Type, class KeyHash>
+  int Graph<Type, KeyHash>::positionCount() const
+  {
+    return count;
+  }
+  
+  template<class Type, class KeyHash>
+  int Graph<Type, KeyHash>::edgeCount() const
   {
     return  edgeCountNum;
   }
+  
+  template<class Type, class KeyHash>
+  inline bool Graph<Type, KeyHash>::containsVertex(int vertexIndex) const
+  {
+    return vertexIndex >= 0 && vertexIndex < count;
+  }
       
-  template<class Type>
-  int Graph<Type>::edgeWeight(const Type& fromVertex,const Type& toVertex) const throw (std::logic_error)
+  template<class Type, class KeyHash>
+  int Graph<Type, KeyHash>::edgeWeight(const Type& fromVertex,const Type& toVertex) const throw (std::logic_error)
   {
-    int indexFrom;
-    int indexTo;
-    
-    bool isAdjacent = false;
+    return edgeWeightAt(findVertex(fromVertex), findVertex(toVertex));
+  }
+      
+  template<class Type, class KeyHash>
+  int Graph<Type, KeyHash>::edgeWeight(VertexHandle fromVertex, VertexHandle toVertex) const throw (std::logic_error)
+  {
+    return edgeWeightAt(positionOf(fromVertex), positionOf(toVertex));
+  }
+      
+  template<class Type, class KeyHash>
+  int Graph<Type, KeyHash>::edgeWeightAt(int indexFrom, int indexTo) const
+  {
+    int slot = -1;
+    try
+    {
+      if(indexFrom != -1 && indexTo != -1)
+        slot = findEdgeAt(indexFrom, indexTo);
+      if(slot == -1)
+        throw std::logic_error("Following edege doesn't exist. -1");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return -1;
+    }
+    return rowAt(indexFrom)[slot].edgeWeight;
+  } 
+       
+  template<class Type, class KeyHash>
+  void Graph<Type, KeyHash>::deleteEdge(const Type& fromVertex, const Type& toVertex) throw (std::logic_error)
+  {
+    deleteEdgeAt(findVertex(fromVertex), findVertex(toVertex));
+  }
+       
+  template<class Type, class KeyHash>
+  void Graph<Type, KeyHash>::deleteEdge(VertexHandle fromVertex, VertexHandle toVertex) throw (std::logic_error)
+  {
+    deleteEdgeAt(positionOf(fromVertex), positionOf(toVertex));
+  }
+       
+  template<class Type, class KeyHash>
+  void Graph<Type, KeyHash>::removeEntry(int vertexIndex, int slot)
+  {
+    ConnectedVertices<Type>* row = rowAt(vertexIndex);
+    std::copy(row + slot + 1, row + countAdj[vertexIndex], row + slot);
+    countAdj[vertexIndex]--;
+  }
+       
+  template<class Type, class KeyHash>
+  void Graph<Type, KeyHash>::deleteEdgeAt(int indexFrom, int indexTo)
+  {
+    try
+    {
+      if((indexFrom == -1) || indexTo == -1 )
+        throw std::logic_error("Either or both of the vertices don't exist in the graph. Couldn't perform deletion");
+      
+      int slot = findEdgeAt(indexFrom, indexTo);
+      if(slot == -1)
+        throw std::logic_error("Edge don't exist between the 2 vertices. Couldn't perform deletion");
+      
+      removeEntry(indexFrom, slot);
+      if(direction == UNDIRECTED) // it undirected we gotta delete from both
+        removeEntry(indexTo, findEdgeAt(indexTo, indexFrom));
+      edgeCountNum-=1;
+      connectivityDirty = true;
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+    }
+  }
+
+  template<class Type, class KeyHash>
+  void Graph<Type, KeyHash>::deleteVertex(const Type& vertex) throw (std::logic_error)
+  {
+    int vertexIndex = findVertex(vertex);
+    try
+    {
+      if(vertexIndex == -1)
+	throw std::logic_error("Vertex doesn't exist in the graph. Couldn't perform deletion");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return;
+    }
+    deleteVertexAt(vertexIndex);
+  }
+
+  template<class Type, class KeyHash>
+  void Graph<Type, KeyHash>::deleteVertex(VertexHandle vertex) throw (std::logic_error)
+  {
+    int vertexIndex = positionOf(vertex);
+    try
+    {
+      if(vertexIndex == -1)
+	throw std::logic_error("Vertex handle is not in the graph. Couldn't perform deletion");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return;
+    }
+    deleteVertexAt(vertexIndex);
+  }
+
+  template<class Type, class KeyHash>
+  void Graph<Type, KeyHash>::deleteVertexAt(int vertexIndex)
+  {
+    //first delete all the relationships that the vertex has with other vertices
+    int removedEdges = 0;
+    for(int i = 0; i < count; i++)
+    {
+      if(i == vertexIndex)
+        continue;
+      ConnectedVertices<Type>* row = rowAt(i);
+      int kept = 0;
+      for(int j = 0; j < countAdj[i]; j++)
+      {
+        if(row[j].connIndex != vertexIndex)
+          row[kept++] = row[j];
+        else if(direction == DIRECTED)
+          removedEdges++;
+      }
+      countAdj[i] = kept;
+    }
+    const ConnectedVertices<Type>* ownRow = rowAt(vertexIndex);
+    int selfLoopEntries = 0;
+    for(int j = 0; j < countAdj[vertexIndex]; j++)
+    {
+      if(ownRow[j].connIndex == vertexIndex)
+        selfLoopEntries++;
+    }
+    if(direction == DIRECTED)
+      removedEdges += countAdj[vertexIndex];
+    else // an undirected self loop is stored twice on its vertex
+      removedEdges += countAdj[vertexIndex] - selfLoopEntries + selfLoopEntries / 2;
     
-    bool from_exists = false;
-    bool to_exists = false;
+    //then give back its handle, the info column itself never moves
+    VertexHandle handle = handleOfPosition[vertexIndex];
+    handleOfKey.erase(handle.id, payload);
+    payload[handle.id] = Type();
+    positionOfHandle[handle.id] = -1;
+    generationOfHandle[handle.id]++;
+    freeHandles.push_back(handle.id);
     
-    bool edgeExist = false;
+    //then close the gap in the topology and renumber the positions after it
+    for(int i = vertexIndex; i < count - 1; i++)
+    {
+      countAdj[i] = countAdj[i + 1];
+      handleOfPosition[i] = handleOfPosition[i + 1];
+      positionOfHandle[handleOfPosition[i].id] = i;
+      std::copy(rowAt(i + 1), rowAt(i + 1) + countAdj[i], rowAt(i));
+    }
+    count--;
+    countAdj[count] = 0;
+    handleOfPosition[count] = NO_VERTEX;
+    for(int i = 0; i < count; i++)
+    {
+      ConnectedVertices<Type>* row = rowAt(i);
+      for(int j = 0; j < countAdj[i]; j++)
+      {
+        if(row[j].connIndex > vertexIndex)
+          row[j].connIndex--;
+      }
+    }
+    edgeCountNum -= removedEdges;
+    connectivityDirty = true;
+  }
     
-    int edgeWeightNum = -1;
+  template<class Type, class KeyHash>
+  int Graph<Type, KeyHash>::findVertex(const Type& vertex) const
+  {
+    return positionOf(handleOf(vertex));
+  }
+
+  template<class Type, class KeyHash>
+  void Graph<Type, KeyHash>::destroy()
+  {
+    initStorage();
+    connectivityDirty = true;
+  }
+
+  template<class Type, class KeyHash>
+  Graph<Type, KeyHash>::~Graph()
+  {
+  }
+
 
-    for(int i=0; i< count; i++)
+  template<class Type, class KeyHash>
+  const Graph<Type, KeyHash>& Graph<Type, KeyHash>::operator= (const Graph<Type, KeyHash>& otherGraph)
+  {
+    if(this == &otherGraph)
+      return *this;
+    
+    weigh = otherGraph.weigh;
+    direction = otherGraph.direction;
+    count = otherGraph.count;
+    edgeCountNum = otherGraph.edgeCountNum;
+    countAdj = otherGraph.countAdj;
+    adjacency = otherGraph.adjacency;
+    handleOfPosition = otherGraph.handleOfPosition;
+    payload = otherGraph.payload;
+    positionOfHandle = otherGraph.positionOfHandle;
+    generationOfHandle = otherGraph.generationOfHandle;
+    freeHandles = otherGraph.freeHandles;
+    handleOfKey = otherGraph.handleOfKey;
+    connectivityEnabled = otherGraph.connectivityEnabled.load();
+    connectivityDirty = otherGraph.connectivityDirty.load();
+    connectivity = otherGraph.connectivity;
+    reachabilityBuilt = otherGraph.reachabilityBuilt.load();
+    reachability = otherGraph.reachability;
+    return *this;
+  }
+  
+  //copy constructor
+  template<class Type, class KeyHash>
+  Graph<Type, KeyHash>::Graph(const Graph<Type, KeyHash>& otherGraph) 
+    : weigh(otherGraph.weigh), direction(otherGraph.direction), edgeCountNum(otherGraph.edgeCountNum),
+      count(otherGraph.count), countAdj(otherGraph.countAdj), adjacency(otherGraph.adjacency),
+      handleOfPosition(otherGraph.handleOfPosition), payload(otherGraph.payload),
+      positionOfHandle(otherGraph.positionOfHandle), generationOfHandle(otherGraph.generationOfHandle),
+      freeHandles(otherGraph.freeHandles),
+      handleOfKey(otherGraph.handleOfKey), connectivityEnabled(otherGraph.connectivityEnabled.load()),
+      connectivityDirty(otherGraph.connectivityDirty.load()), connectivity(otherGraph.connectivity),
+      reachabilityBuilt(otherGraph.reachabilityBuilt.load()), reachability(otherGraph.reachability)
+  {
+  }
+  
+  /**
+  * Function: forEachEdgeOnce
+  * Description: calls func(connIndex, edgeWeight) for the edges of one
+  *              vertex so that, over all vertices, every edge is seen once:
+  *              undirected edges are stored on both ends and seen from the
+  *              lower position, an undirected self loop is stored twice on
+  *              its vertex and seen once per stored pair
+  * Function input: a graph, the position of the vertex and a callable
+  * Function output: none
+  */
+  template<class GraphType, class Func>
+  inline void forEachEdgeOnce(const GraphType& graph, int vertexIndex, Func func)
+  {
+    bool undirected = graph.direction == UNDIRECTED;
+    bool skipSelfLoop = false;
+    graph.forEachNeighbor(vertexIndex, [&](int connIndex, int edgeWeight)
     {
-      if(from_exists == false)
+      if(undirected && connIndex < vertexIndex)
+        return;
+      if(undirected && connIndex == vertexIndex)
       {
-	if(node[i].info == fromVertex)
-	{
-	  from_exists = true;
-	  indexFrom = i;
-	}
+        skipSelfLoop = !skipSelfLoop;
+        if(!skipSelfLoop)
+          return;
       }
-      if(to_exists == false)
+      func(connIndex, edgeWeight);
+    });
+  }
+  
+  /**
+  * Function: collectUndirectedEdges
+  * Description: gathers every undirected edge of a graph once, skipping
+  *              self loops
+  * Function input: a graph
+  * Function output: the edges with fromIndex < toIndex
+  */
+  template<class GraphType>
+  std::vector<WeightedEdge> collectUndirectedEdges(const GraphType& graph)
+  {
+    std::vector<WeightedEdge> edges;
+    edges.reserve(graph.edgeCount());
+    graph.forEachEdge([&](int from, int to, int weight)
+    {
+      if(from < to)
       {
-	if(node[i].info == toVertex)
-	{
-	  to_exists = true; 
-	  indexTo = i;
-	}
+        WeightedEdge edge = {from, to, weight};
+        edges.push_back(edge);
       }
-    }
-    try
+    });
+    return edges;
+  }
+  
+  /**
+  * Function: kruskalSpanningForest
+  * Description: Kruskal's algorithm, the edges are sorted in parallel and
+  *              then scanned once against a union-find
+  * Function input: an undirected graph and the number of threads
+  * Function output: the minimum spanning forest
+  */
+  template<class GraphType>
+  SpanningForest kruskalSpanningForest(const GraphType& graph, int threads)
+  {
+    SpanningForest forest;
+    forest.totalWeight = 0;
+    
+    std::vector<WeightedEdge> edges = collectUndirectedEdges(graph);
+    threads = resolveThreadCount(threads, static_cast<long long>(edges.size()));
+    parallelSort(edges, [](const WeightedEdge& a, const WeightedEdge& b)
+    {
+      if(a.edgeWeight != b.edgeWeight)
+        return a.edgeWeight < b.edgeWeight;
+      if(a.fromIndex != b.fromIndex)
+        return a.fromIndex < b.fromIndex;
+      return a.toIndex < b.toIndex;
+    }, threads);
+    
+    int vertices = graph.positionCount();
+    DisjointSet components(vertices);
+    for(size_t i = 0; i < edges.size() && static_cast<int>(forest.edges.size()) < vertices - 1; i++)
     {
-      for(int i=0; i< node[indexFrom].countAdj; i++)
+      if(components.unite(edges[i].fromIndex, edges[i].toIndex))
       {
-	if(indexTo == node[indexFrom].edge[i].connIndex) 
-	{
-	  edgeExist = true;
-	  edgeWeightNum = node[indexFrom].edge[i].edgeWeight;
-	  break;
-	}
+        forest.edges.push_back(edges[i]);
+        forest.totalWeight += edges[i].edgeWeight;
       }
-    if(edgeExist == false)
-      throw std::logic_error("Following edege doesn't exist. -1");
-    }
-    catch(const std::logic_error bad_item)
-    {
-      cerr << "logic_error: " << bad_item.what() << '\n';
     }
-    return edgeWeightNum;
-  } 
-       
-  template<class Type>
-  void Graph<Type>::deleteEdge(const Type& fromVertex, const Type& toVertex) throw (std::logic_error)
+    return forest;
+  }
+  
+  /**
+  * Function: boruvkaSpanningForest
+  * Description: Boruvka's algorithm, each round every thread finds the
+  *              cheapest edge leaving each component within its slice of the
+  *              remaining edges, the slices are reduced, the components are
+  *              merged and edges inside a component are dropped
+  * Function input: an undirected graph and the number of threads
+  * Function output: the minimum spanning forest
+  */
+  template<class GraphType>
+  SpanningForest boruvkaSpanningForest(const GraphType& graph, int threads)
   {
-    int indexFrom;
-    int indexTo;
+    SpanningForest forest;
+    forest.totalWeight = 0;
     
-    bool isAdjacent = false;
+    int vertices = graph.positionCount();
+    std::vector<WeightedEdge> edges = collectUndirectedEdges(graph);
+    threads = resolveThreadCount(threads, static_cast<long long>(edges.size()));
     
-    bool from_exists = false;
-    bool to_exists = false;
+    std::vector<int> component(vertices);
+    for(int v = 0; v < vertices; v++)
+      component[v] = v;
+    DisjointSet components(vertices);
     
-    int edgeWeightNum;
+    // ties are broken by position in the edge list so that the order is total
+    // and no cycle can be formed by equal weights
+    std::vector<std::vector<int> > cheapest(threads, std::vector<int>(vertices));
+    std::vector<std::vector<WeightedEdge> > kept(threads);
     
-    int deleteIndex;
-
-    for(int i=0; i< count; i++)
+    while(!edges.empty())
     {
-      if(from_exists == false)
+      // parallelFor runs fewer chunks once the edge list is shorter than the
+      // thread count, so every slot is reset here rather than by its chunk
+      for(int t = 0; t < threads; t++)
       {
-	if(node[i].info == fromVertex)
-	{
-	  from_exists = true;
-	  indexFrom = i;
-	}
+        std::fill(cheapest[t].begin(), cheapest[t].end(), -1);
+        kept[t].clear();
       }
-      if(to_exists == false)
+      parallelFor(0, static_cast<long long>(edges.size()), threads, [&](long long first, long long last, int t)
       {
-	if(node[i].info == toVertex)
-	{
-	  to_exists = true; 
-	  indexTo = i;
-	}
+        std::vector<int>& best = cheapest[t];
+        for(long long i = first; i < last; i++)
+        {
+          const WeightedEdge& edge = edges[i];
+          int ends[2] = {component[edge.fromIndex], component[edge.toIndex]};
+          for(int k = 0; k < 2; k++)
+          {
+            int current = best[ends[k]];
+            if(current == -1 || edge.edgeWeight < edges[current].edgeWeight)
+              best[ends[k]] = static_cast<int>(i);
+          }
+        }
+      });
+      
+      std::vector<int>& best = cheapest[0];
+      for(int t = 1; t < threads; t++)
+      {
+        for(int c = 0; c < vertices; c++)
+        {
+          int candidate = cheapest[t][c];
+          if(candidate != -1 && (best[c] == -1 || edges[candidate].edgeWeight < edges[best[c]].edgeWeight))
+            best[c] = candidate;
+        }
+      }
+      
+      for(int c = 0; c < vertices; c++)
+      {
+        if(best[c] == -1)
+          continue;
+        const WeightedEdge& edge = edges[best[c]];
+        if(components.unite(edge.fromIndex, edge.toIndex))
+        {
+          forest.edges.push_back(edge);
+          forest.totalWeight += edge.edgeWeight;
+        }
       }
+      
+      for(int v = 0; v < vertices; v++)
+        component[v] = components.find(v);
+      
+      parallelFor(0, static_cast<long long>(edges.size()), threads, [&](long long first, long long last, int t)
+      {
+        for(long long i = first; i < last; i++)
+        {
+          if(component[edges[i].fromIndex] != component[edges[i].toIndex])
+            kept[t].push_back(edges[i]);
+        }
+      });
+      edges.clear();
+      for(int t = 0; t < threads; t++)
+        edges.insert(edges.end(), kept[t].begin(), kept[t].end());
     }
-    if(direction == 0)
+    return forest;
+  }
+  
+  template<class Type, class KeyHash>
+  SpanningForest Graph<Type, KeyHash>::minimumSpanningForest(SpanningAlgorithm algorithm, int threads) const throw (std::logic_error)
+  {
+    try
     {
-      try
-      {
-	if((from_exists == false) || to_exists == false )
-	    throw std::logic_error("Either or both of the vertices don't exist in the graph. Couldn't perform deletion");
-      
-	bool edgeExists = false;
-	for(int i = 0; i < node[indexFrom].countAdj; i++)
-	{
-	  if(node[indexFrom].edge[i].connIndex == indexTo)
-	  {
-	    deleteIndex = i;
-	    edgeExists = true;
-	    break;
-	  }
-	}
-
-	try
-	{
-	  if(edgeExists == false)
-	    throw std::logic_error("Edge don't exist between the 2 vertices. Couldn't perform deletion");
-	  
-	  int j = 0;
-	  while(j != deleteIndex)
-	  {
-	    j++;
-	  }
-	  
-	  while(j < node[indexFrom].countAdj)
-	  {
-	    node[indexFrom].edge[j] = node[indexFrom].edge[j +1];
-	    j++;
-	  }
-	  node[indexFrom].countAdj--;
-	}
-	catch(const std::logic_error bad_item)
-	{
-	  cerr << "logic_error: " << bad_item.what() << '\n';
-	}
-      }
-      catch(const std::logic_error bad_item)
+      if(weigh != WEIGHTED || direction != UNDIRECTED)
+        throw std::logic_error("Minimum spanning forest needs a WEIGHTED and UNDIRECTED graph");
+    }
+    catch(const std::logic_error bad_graph)
+    {
+      cerr << "logic_error: " << bad_graph.what() << '\n';
+      SpanningForest empty;
+      empty.totalWeight = 0;
+      return empty;
+    }
+    
+    if(algorithm == BORUVKA)
+      return boruvkaSpanningForest(*this, threads);
+    return kruskalSpanningForest(*this, threads);
+  }
+  
+  /**
+  * Description: Incoming edges of every vertex in compressed rows, built
+  * from the outgoing adjacency lists of a graph
+  */
+  struct PredecessorLists
+  {
+    std::vector<int> offset; // incoming edges of v are [offset[v], offset[v + 1])
+    std::vector<int> source; // vertex the edge comes from
+    std::vector<int> weight; // weight of the edge
+    
+    template<class GraphType>
+    explicit PredecessorLists(const GraphType& graph)
+    {
+      int vertices = graph.positionCount();
+      offset.assign(vertices + 1, 0);
+      graph.forEachEdge([&](int, int to, int)
       {
-	cerr << "logic_error: " << bad_item.what() << '\n';
-      }
+        offset[to + 1]++;
+      });
+      for(int v = 0; v < vertices; v++)
+        offset[v + 1] += offset[v];
+      
+      source.resize(offset[vertices]);
+      weight.resize(offset[vertices]);
+      std::vector<int> next(offset.begin(), offset.end() - 1);
+      graph.forEachEdge([&](int from, int to, int edgeWeight)
+      {
+        source[next[to]] = from;
+        weight[next[to]] = edgeWeight;
+        next[to]++;
+      });
     }
-    else if(direction == 1) // it undirected we gotta delete from both
-    {
-      try
-      {
-	if((from_exists == false) || to_exists == false )
-	    throw std::logic_error("Either or both of the vertices don't exist in the graph. Couldn't perform deletion");
-      
-	bool edgeExists = false;
-	for(int i = 0; i < node[indexTo].countAdj; i++)
-	{
-	  if(node[indexTo].edge[i].connIndex == indexFrom)
-	  {
-	    deleteIndex = i;
-	    edgeExists = true;
-	    break;
-	  }
-	}
-	  
-	int j = 0;
-	while(j != deleteIndex)
-	{
-	  j++;
-	}
-	
-	while(j < node[indexTo].countAdj)
-	{
-	  node[indexTo].edge[j] = node[indexTo].edge[j +1];
-	  j++;
-	}
-	node[indexTo].countAdj--;
-	
-	bool edgeExistss = false;
-	for(int i = 0; i < node[indexFrom].countAdj; i++)
-	{
-	  if(node[indexFrom].edge[i].connIndex == indexTo)
-	  {
-	    deleteIndex = i;
-	    edgeExistss = true;
-	    break;
-	  }
-	}
-	int k = 0;
-	while(k != deleteIndex)
-	{
-	  k++;
-	}
-	
-	while(k < node[indexFrom].countAdj)
-	{
-	  node[indexFrom].edge[k] = node[indexFrom].edge[k +1];
-	  k++;
-	}
-	node[indexFrom].countAdj--;
-      }
-      catch(const std::logic_error bad_item)
+  };
+  
+  /**
+  * Function: findCycleAmong
+  * Description: every vertex left over by Kahn's algorithm still has a
+  *              left over predecessor, so walking predecessors from any of
+  *              them must repeat a vertex
+  * Function input: the predecessor lists, the topological positions and
+  *                 one left over vertex
+  * Function output: one directed cycle in forward order
+  */
+  inline std::vector<int> findCycleAmong(const PredecessorLists& incoming, const std::vector<int>& position, int start)
+  {
+    std::vector<int> walk;
+    std::vector<int> stepOf(position.size(), -1);
+    int current = start;
+    while(current != -1 && stepOf[current] == -1)
+    {
+      stepOf[current] = static_cast<int>(walk.size());
+      walk.push_back(current);
+      int previous = -1;
+      for(int e = incoming.offset[current]; e < incoming.offset[current + 1] && previous == -1; e++)
       {
-	cerr << "logic_error: " << bad_item.what() << '\n';
+        if(position[incoming.source[e]] == -1)
+          previous = incoming.source[e];
       }
-    } 
-    edgeCountNum-=1;
+      current = previous;
+    }
+    
+    std::vector<int> cycle;
+    if(current != -1)
+      cycle.assign(walk.rbegin(), walk.rend() - stepOf[current]);
+    return cycle;
   }
-
-  template<class Type>
-  void Graph<Type>::deleteVertex(const Type& vertex) throw (std::logic_error)
+  
+  /**
+  * Function: kahnTopologicalSort
+  * Description: Kahn's algorithm in frontier batches. The in-degree counters
+  *              are atomic so every thread can retire edges of its slice of
+  *              the frontier; whichever thread drops a counter to zero owns
+  *              that vertex for the next batch. Each batch is sorted so the
+  *              result does not depend on the number of threads.
+  * Function input: a directed graph and the number of threads
+  * Function output: the topological order
+  */
+  template<class GraphType>
+  TopologicalOrder kahnTopologicalSort(const GraphType& graph, int threads)
   {
-    int vertexIndexNumDelete;
-    bool vertex_exists = false;
+    int vertices = graph.positionCount();
+    threads = resolveThreadCount(threads, graph.edgeCount());
     
-    int edgeWeightNum;
+    TopologicalOrder result;
+    result.order.reserve(vertices);
+    result.position.assign(vertices, -1);
+    result.level.assign(vertices, -1);
     
-    int deleteIndex;
-
-    for(int i=0; i< count; i++)
+    std::vector<std::atomic<int> > inDegree(vertices);
+    for(int v = 0; v < vertices; v++)
+      inDegree[v].store(0, std::memory_order_relaxed);
+    parallelFor(0, vertices, threads, [&](long long first, long long last, int)
     {
-      if(vertex_exists == false)
+      for(long long u = first; u < last; u++)
       {
-	if(node[i].info == vertex)
-	{
-	  vertex_exists = true;
-	  vertexIndexNumDelete = i;
-	}
+        graph.forEachNeighbor(static_cast<int>(u), [&](int to, int)
+        {
+          inDegree[to].fetch_add(1, std::memory_order_relaxed);
+        });
       }
-    }
-    try
+    });
+    
+    std::vector<int> frontier;
+    int selected = 0;
+    for(int v = 0; v < vertices; v++)
     {
-      if(vertex_exists == false)
-	throw std::logic_error("Vertex doesn't exist in the graph. Couldn't perform deletion");
+      if(!graph.containsVertex(v))
+        continue;
+      selected++;
+      if(inDegree[v].load(std::memory_order_relaxed) == 0)
+        frontier.push_back(v);
+    }
     
-      //first delete all the relationships that the vertex has with other vertices
-      for(int i=0; i<count; i++)
-      {
-	for(int j=0; j < node[i].countAdj; j++)
-	{
-	  if(node[i].edge[j].connIndex == vertexIndexNumDelete)
-	  {
-	    deleteEdge(node[i].info,node[vertexIndexNumDelete].info);
-	  }
-	  else{} //do nothing
-	}
+    std::vector<std::vector<int> > discovered(threads);
+    for(int level = 0; !frontier.empty(); level++)
+    {
+      for(size_t i = 0; i < frontier.size(); i++)
+      {
+        result.position[frontier[i]] = static_cast<int>(result.order.size());
+        result.level[frontier[i]] = level;
+        result.order.push_back(frontier[i]);
       }
       
-      //then delete the vertex itself
-      int j = 0;
-      while(j != vertexIndexNumDelete)
+      int batchThreads = resolveThreadCount(threads, static_cast<long long>(frontier.size()), 256);
+      for(int t = 0; t < batchThreads; t++)
+        discovered[t].clear();
+      parallelFor(0, static_cast<long long>(frontier.size()), batchThreads, [&](long long first, long long last, int t)
       {
-	j++;
-      }
+        for(long long i = first; i < last; i++)
+        {
+          graph.forEachNeighbor(frontier[i], [&](int to, int)
+          {
+            if(inDegree[to].fetch_sub(1, std::memory_order_acq_rel) == 1)
+              discovered[t].push_back(to);
+          });
+        }
+      });
+      
+      frontier.clear();
+      for(int t = 0; t < batchThreads; t++)
+        frontier.insert(frontier.end(), discovered[t].begin(), discovered[t].end());
+      std::sort(frontier.begin(), frontier.end());
+    }
+    
+    result.acyclic = static_cast<int>(result.order.size()) == selected;
+    if(!result.acyclic)
+    {
+      int start = 0;
+      while(!graph.containsVertex(start) || result.position[start] != -1)
+        start++;
+      result.cycle = findCycleAmong(PredecessorLists(graph), result.position, start);
+    }
+    return result;
+  }
   
-      while(j < count)
+  /**
+  * Function: dagPaths
+  * Description: relaxes the vertices one topological level at a time. A
+  *              vertex only depends on predecessors from earlier levels, so
+  *              every vertex of a level pulls from its predecessors in parallel.
+  * Function input: a directed graph, the start vertex (-1 to start from every
+  *                 source), whether to maximise or minimise and the number of threads
+  * Function output: the path lengths and predecessors
+  */
+  template<class GraphType>
+  DagPaths dagPaths(const GraphType& graph, int start, bool longest, int threads)
+  {
+    int vertices = graph.positionCount();
+    TopologicalOrder sorted = kahnTopologicalSort(graph, threads);
+    
+    DagPaths paths;
+    paths.acyclic = sorted.acyclic;
+    paths.distance.assign(vertices, UNREACHABLE);
+    paths.predecessor.assign(vertices, -1);
+    if(!sorted.acyclic)
+      return paths;
+    
+    PredecessorLists incoming(graph);
+    bool unitWeights = graph.weigh == UNWEIGHTED;
+    threads = resolveThreadCount(threads, static_cast<long long>(incoming.source.size()));
+    
+    size_t levelBegin = 0;
+    while(levelBegin < sorted.order.size())
+    {
+      size_t levelEnd = levelBegin;
+      int level = sorted.level[sorted.order[levelBegin]];
+      while(levelEnd < sorted.order.size() && sorted.level[sorted.order[levelEnd]] == level)
+        levelEnd++;
+      
+      int levelThreads = resolveThreadCount(threads, static_cast<long long>(levelEnd - levelBegin), 256);
+      parallelFor(static_cast<long long>(levelBegin), static_cast<long long>(levelEnd), levelThreads,
+                  [&](long long first, long long last, int)
       {
-	node[j] = node[j +1];
-	node[j].vertexIndex = j;
-	j++;
-      }
-      count--;
+        for(long long i = first; i < last; i++)
+        {
+          int v = sorted.order[i];
+          if(v == start || (start == -1 && incoming.offset[v] == incoming.offset[v + 1]))
+          {
+            paths.distance[v] = 0;
+            continue;
+          }
+          
+          long long best = UNREACHABLE;
+          int bestFrom = -1;
+          for(int e = incoming.offset[v]; e < incoming.offset[v + 1]; e++)
+          {
+            int from = incoming.source[e];
+            if(paths.distance[from] == UNREACHABLE)
+              continue;
+            long long candidate = paths.distance[from] + (unitWeights ? 1 : incoming.weight[e]);
+            if(bestFrom == -1 || (longest ? candidate > best : candidate < best))
+            {
+              best = candidate;
+              bestFrom = from;
+            }
+          }
+          paths.distance[v] = best;
+          paths.predecessor[v] = bestFrom;
+        }
+      });
+      levelBegin = levelEnd;
     }
-    catch(const std::logic_error bad_item)
+    return paths;
+  }
+  
+  /**
+  * Function: tracePath
+  * Description: follows the predecessors back from a vertex
+  * Function input: the computed paths and the position of the last vertex
+  * Function output: the vertex positions along the path from its start to
+  *                  the vertex, empty if the vertex is unreachable
+  */
+  inline std::vector<int> tracePath(const DagPaths& paths, int vertexIndex)
+  {
+    std::vector<int> path;
+    if(paths.distance[vertexIndex] == UNREACHABLE)
+      return path;
+    for(int v = vertexIndex; v != -1; v = paths.predecessor[v])
+      path.push_back(v);
+    std::reverse(path.begin(), path.end());
+    return path;
+  }
+  
+  template<class Type, class KeyHash>
+  void Graph<Type, KeyHash>::noteVertexInserted()
+  {
+    if(!connectivityEnabled || connectivityDirty)
+      return;
+    connectivity.add();
+    if(reachabilityBuilt)
     {
-      cerr << "logic_error: " << bad_item.what() << '\n';
+      size_t words = (count + 63) / 64;
+      for(size_t i = 0; i < reachability.size(); i++)
+        reachability[i].resize(words, 0);
+      reachability.push_back(std::vector<unsigned long long>(words, 0));
+      reachability.back()[(count - 1) / 64] |= 1ULL << ((count - 1) % 64);
     }
   }
-    
-  template<class Type>
-  int Graph<Type>::findVertex(const Type& vertex) const
+  
+  template<class Type, class KeyHash>
+  void Graph<Type, KeyHash>::noteEdgeInserted(int indexFrom, int indexTo)
   {
-    int vertexIndex = -1;
-    bool exists = false;
-
-    for(int i=0; i< count; i++)
+    if(!connectivityEnabled || connectivityDirty)
+      return;
+    connectivity.unite(indexFrom, indexTo);
+    if(!reachabilityBuilt || direction != DIRECTED)
+      return;
+    
+    // everything that reaches indexFrom now also reaches whatever indexTo reaches
+    const std::vector<unsigned long long>& fromRow = reachability[indexFrom];
+    if(fromRow[indexTo / 64] & (1ULL << (indexTo % 64)))
+      return;
+    std::vector<unsigned long long> gained = reachability[indexTo];
+    for(int i = 0; i < count; i++)
     {
-      if(exists == false)
+      std::vector<unsigned long long>& row = reachability[i];
+      if(row[indexFrom / 64] & (1ULL << (indexFrom % 64)))
       {
-	if(node[i].info == vertex)
-	{
-	  exists = true;
-	  vertexIndex = i;
-	}
+        for(size_t w = 0; w < row.size(); w++)
+          row[w] |= gained[w];
       }
     }
-      return vertexIndex;
   }
-
-  template<class Type>
-  void Graph<Type>::destroy()
+  
+  template<class Type, class KeyHash>
+  void Graph<Type, KeyHash>::refreshConnectivity(bool needReachability) const
   {
-    delete [] node;
-    node = new Vertex<Type>[100];
-    count = 0;
-    edgeCountNum = 0;
+    // the flags are cleared only once their part of the index is complete
+    if(connectivityEnabled && !connectivityDirty && (!needReachability || reachabilityBuilt))
+      return;
+    std::lock_guard<std::mutex> guard(connectivityLock);
+    connectivityEnabled = true;
+    if(connectivityDirty)
+    {
+      connectivity.reset(count);
+      forEachEdge([&](int from, int to, int)
+      {
+        connectivity.unite(from, to);
+      });
+      reachabilityBuilt = false;
+      connectivityDirty = false;
+    }
+    
+    if(needReachability && !reachabilityBuilt)
+    {
+      // one breadth first search per source, each writing only its own row
+      size_t words = (count + 63) / 64;
+      reachability.assign(count, std::vector<unsigned long long>(words, 0));
+      int threads = resolveThreadCount(0, static_cast<long long>(count) * (edgeCountNum + 1), 1 << 16);
+      parallelFor(0, count, threads, [&](long long first, long long last, int)
+      {
+        std::vector<int> queue;
+        for(long long source = first; source < last; source++)
+        {
+          std::vector<unsigned long long>& row = reachability[source];
+          queue.assign(1, static_cast<int>(source));
+          row[source / 64] |= 1ULL << (source % 64);
+          for(size_t head = 0; head < queue.size(); head++)
+          {
+            forEachNeighbor(queue[head], [&](int to, int)
+            {
+              if(!(row[to / 64] & (1ULL << (to % 64))))
+              {
+                row[to / 64] |= 1ULL << (to % 64);
+                queue.push_back(to);
+              }
+            });
+          }
+        }
+      });
+      reachabilityBuilt = true;
+    }
   }
-
-  template<class Type>
-  Graph<Type>::~Graph()
+  
+  template<class Type, class KeyHash>
+  bool Graph<Type, KeyHash>::connected(const Type& fromVertex, const Type& toVertex) const throw (std::logic_error)
   {
-    delete [] node;
+    return connectedAt(findVertex(fromVertex), findVertex(toVertex));
   }
-
-
-  template<class Type>
-  const Graph<Type>& Graph<Type>::operator= (const Graph<Type>& otherGraph)
+  
+  template<class Type, class KeyHash>
+  bool Graph<Type, KeyHash>::connected(VertexHandle fromVertex, VertexHandle toVertex) const throw (std::logic_error)
   {
-    node = new Vertex<Type>[100];
+    return connectedAt(positionOf(fromVertex), positionOf(toVertex));
+  }
+  
+  template<class Type, class KeyHash>
+  bool Graph<Type, KeyHash>::connectedAt(int indexFrom, int indexTo) const
+  {
+    try
+    {
+      if(indexFrom == -1 || indexTo == -1)
+        throw std::logic_error("Either or both of the vertices don't exist in the graph. Cannot check connectivity");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return false;
+    }
     
-    weigh = otherGraph.weigh;
-    direction = otherGraph.direction;
-    count = otherGraph.count;
-    edgeCountNum = otherGraph.edgeCountNum;
+    refreshConnectivity(false);
+    return connectivity.root(indexFrom) == connectivity.root(indexTo);
+  }
+  
+  template<class Type, class KeyHash>
+  bool Graph<Type, KeyHash>::reachable(const Type& fromVertex, const Type& toVertex) const throw (std::logic_error)
+  {
+    return reachableAt(findVertex(fromVertex), findVertex(toVertex));
+  }
+  
+  template<class Type, class KeyHash>
+  bool Graph<Type, KeyHash>::reachable(VertexHandle fromVertex, VertexHandle toVertex) const throw (std::logic_error)
+  {
+    return reachableAt(positionOf(fromVertex), positionOf(toVertex));
+  }
+  
+  template<class Type, class KeyHash>
+  bool Graph<Type, KeyHash>::reachableAt(int indexFrom, int indexTo) const
+  {
+    if(direction != DIRECTED)
+      return connectedAt(indexFrom, indexTo);
     
-    for(int i=0; i<otherGraph.count; i++)
+    try
     {
-      node[i] = otherGraph.node[i];
+      if(indexFrom == -1 || indexTo == -1)
+        throw std::logic_error("Either or both of the vertices don't exist in the graph. Cannot check reachability");
     }
-    return *this;
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return false;
+    }
+    
+    refreshConnectivity(true);
+    return (reachability[indexFrom][indexTo / 64] >> (indexTo % 64)) & 1ULL;
   }
   
-  //copy constructor
-  template<class Type>
-  Graph<Type>::Graph(const Graph<Type>& otherGraph) 
+  template<class Type, class KeyHash>
+  void Graph<Type, KeyHash>::buildConnectivityIndex(bool withReachability) const
+  {
+    refreshConnectivity(withReachability && direction == DIRECTED);
+  }
+  
+  template<class Type, class KeyHash>
+  void Graph<Type, KeyHash>::dropConnectivityIndex()
   {
-    node = new Vertex<Type>[100];
+    connectivityEnabled = false;
+    connectivityDirty = true;
+    reachabilityBuilt = false;
+    connectivity.reset(0);
+    std::vector<std::vector<unsigned long long> >().swap(reachability);
+  }
+  
+  template<class Type, class KeyHash>
+  Graph<Type, KeyHash> Graph<Type, KeyHash>::inducedSubgraph(const std::vector<int>& vertexIndices, int threads) const
+  {
+    return inducedSubgraph(vertexIndices, AllEdges(), threads);
+  }
+  
+  template<class Type, class KeyHash>
+  template<class EdgeFilter>
+  Graph<Type, KeyHash> Graph<Type, KeyHash>::inducedSubgraph(const std::vector<int>& vertexIndices, EdgeFilter keepEdge, int threads) const
+  {
+    Graph subgraph(direction, weigh);
     
-    weigh = otherGraph.weigh;
-    direction = otherGraph.direction;
-    count = otherGraph.count;
-    edgeCountNum = otherGraph.edgeCountNum;
+    std::vector<int> newIndex(count, -1);
+    std::vector<int> kept;
+    kept.reserve(vertexIndices.size());
+    for(size_t i = 0; i < vertexIndices.size(); i++)
+    {
+      int old = vertexIndices[i];
+      if(containsVertex(old) && newIndex[old] == -1)
+      {
+        newIndex[old] = static_cast<int>(kept.size());
+        kept.push_back(old);
+      }
+    }
     
-    for(int i=0; i<otherGraph.count; i++)
+    // the keys are interned one at a time, then the adjacency lists are copied in parallel
+    subgraph.payload.reserve(kept.size());
+    for(size_t k = 0; k < kept.size(); k++)
     {
-      node[i] = otherGraph.node[i];
+      VertexHandle handle = {static_cast<unsigned int>(k), 0};
+      subgraph.payload.push_back(infoAt(kept[k]));
+      subgraph.positionOfHandle.push_back(static_cast<int>(k));
+      subgraph.generationOfHandle.push_back(0);
+      subgraph.handleOfKey.insert(handle.id, subgraph.payload);
+      subgraph.handleOfPosition[k] = handle;
+    }
+    
+    threads = resolveThreadCount(threads, static_cast<long long>(kept.size()), 16);
+    std::vector<long long> entries(threads, 0);
+    parallelFor(0, static_cast<long long>(kept.size()), threads, [&](long long first, long long last, int t)
+    {
+      for(long long k = first; k < last; k++)
+      {
+        const ConnectedVertices<Type>* from = rowAt(kept[k]);
+        ConnectedVertices<Type>* to = subgraph.rowAt(static_cast<int>(k));
+        int copied = 0;
+        for(int j = 0; j < countAdj[kept[k]]; j++)
+        {
+          int target = newIndex[from[j].connIndex];
+          if(target != -1 && keepEdge(kept[k], from[j].connIndex, from[j].edgeWeight))
+          {
+            to[copied].connIndex = target;
+            to[copied].edgeWeight = from[j].edgeWeight;
+            copied++;
+          }
+        }
+        subgraph.countAdj[k] = copied;
+        entries[t] += copied;
+      }
+    });
+    
+    long long total = 0;
+    for(int t = 0; t < threads; t++)
+      total += entries[t];
+    subgraph.count = static_cast<int>(kept.size());
+    subgraph.edgeCountNum = static_cast<int>(direction == UNDIRECTED ? total / 2 : total);
+    return subgraph;
+  }
+  
+  template<class Type, class KeyHash>
+  TopologicalOrder Graph<Type, KeyHash>::topologicalSort(int threads) const throw (std::logic_error)
+  {
+    try
+    {
+      if(direction != DIRECTED)
+        throw std::logic_error("Topological sort needs a DIRECTED graph");
+    }
+    catch(const std::logic_error bad_graph)
+    {
+      cerr << "logic_error: " << bad_graph.what() << '\n';
+      TopologicalOrder empty;
+      empty.acyclic = false;
+      return empty;
+    }
+    return kahnTopologicalSort(*this, threads);
+  }
+  
+  template<class Type, class KeyHash>
+  DagPaths Graph<Type, KeyHash>::criticalPaths(int threads) const throw (std::logic_error)
+  {
+    try
+    {
+      if(direction != DIRECTED)
+        throw std::logic_error("Critical paths need a DIRECTED graph");
+    }
+    catch(const std::logic_error bad_graph)
+    {
+      cerr << "logic_error: " << bad_graph.what() << '\n';
+      DagPaths empty;
+      empty.acyclic = false;
+      return empty;
+    }
+    return dagPaths(*this, -1, true, threads);
+  }
+  
+  template<class Type, class KeyHash>
+  DagPaths Graph<Type, KeyHash>::longestPathsFrom(const Type& source, int threads) const throw (std::logic_error)
+  {
+    return pathsFromAt(findVertex(source), true, threads);
+  }
+  
+  template<class Type, class KeyHash>
+  DagPaths Graph<Type, KeyHash>::longestPathsFrom(VertexHandle source, int threads) const throw (std::logic_error)
+  {
+    return pathsFromAt(positionOf(source), true, threads);
+  }
+  
+  template<class Type, class KeyHash>
+  DagPaths Graph<Type, KeyHash>::shortestPathsFrom(const Type& source, int threads) const throw (std::logic_error)
+  {
+    return pathsFromAt(findVertex(source), false, threads);
+  }
+  
+  template<class Type, class KeyHash>
+  DagPaths Graph<Type, KeyHash>::shortestPathsFrom(VertexHandle source, int threads) const throw (std::logic_error)
+  {
+    return pathsFromAt(positionOf(source), false, threads);
+  }
+  
+  template<class Type, class KeyHash>
+  DagPaths Graph<Type, KeyHash>::pathsFromAt(int sourceIndex, bool longest, int threads) const
+  {
+    try
+    {
+      if(direction != DIRECTED)
+        throw std::logic_error(longest ? "Longest paths need a DIRECTED graph" : "Shortest paths need a DIRECTED graph");
+      if(sourceIndex == -1)
+        throw std::logic_error("Vertex doesn't exist in the graph. Cannot compute paths");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      DagPaths empty;
+      empty.acyclic = false;
+      return empty;
     }
+    return dagPaths(*this, sourceIndex, longest, threads);
   }
 }
 #endif
@@ -0,0 +1,489 @@
+#include "graph.h"
+#include <cstring>
+#include <sstream>
+#include <string>
+
+/**
+ * File: graph_export.h
+ * Description: This file contains the definition and implementation of the
+ *              GraphWriter class, which exports a Graph as an edge list,
+ *              DOT, JSON or a binary adjacency file through large reusable
+ *              buffers, optionally formatting chunks of vertices in parallel.
+ */
+
+#ifndef _GRAPH_EXPORT_H_
+#define _GRAPH_EXPORT_H_
+
+namespace GraphNameSpace
+{
+  /**
+  * Description: A growable byte buffer with fast integer formatting
+  */
+    class OutputBuffer
+    {
+    public:
+      void clear() { bytes.clear(); }
+      size_t size() const { return bytes.size(); }
+      const char* data() const { return bytes.data(); }
+      void reserve(size_t capacity) { bytes.reserve(capacity); }
+
+      void append(char c) { bytes.push_back(c); }
+      void append(const char* text, size_t length) { bytes.append(text, length); }
+      void append(const char* text) { bytes.append(text); }
+      void append(const std::string& text) { bytes.append(text); }
+
+      void appendInt(long long value)
+      {
+        static const char pairs[] =
+          "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+          "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+          "8081828384858687888990919293949596979899";
+        char digits[24];
+        char* end = digits + sizeof(digits);
+        char* p = end;
+        unsigned long long magnitude = value < 0 ? 0ULL - static_cast<unsigned long long>(value)
+                                                 : static_cast<unsigned long long>(value);
+        while(magnitude >= 100)
+        {
+          unsigned long long pair = (magnitude % 100) * 2;
+          magnitude /= 100;
+          *--p = pairs[pair + 1];
+          *--p = pairs[pair];
+        }
+        if(magnitude >= 10)
+        {
+          *--p = pairs[magnitude * 2 + 1];
+          *--p = pairs[magnitude * 2];
+        }
+        else
+          *--p = static_cast<char>('0' + magnitude);
+        if(value < 0)
+          *--p = '-';
+        bytes.append(p, end - p);
+      }
+
+      // little endian, whatever the byte order of the host
+      void appendInt32(int value)
+      {
+        unsigned int bits = static_cast<unsigned int>(value);
+        for(int i = 0; i < 4; i++)
+          bytes.push_back(static_cast<char>((bits >> (8 * i)) & 0xff));
+      }
+
+      // overwrites an int32 appended earlier, at its offset in the buffer
+      void patchInt32(size_t at, int value)
+      {
+        unsigned int bits = static_cast<unsigned int>(value);
+        for(int i = 0; i < 4; i++)
+          bytes[at + i] = static_cast<char>((bits >> (8 * i)) & 0xff);
+      }
+
+      void appendInt64(long long value)
+      {
+        unsigned long long bits = static_cast<unsigned long long>(value);
+        for(int i = 0; i < 8; i++)
+          bytes.push_back(static_cast<char>((bits >> (8 * i)) & 0xff));
+      }
+
+      // appends a double quoted JSON string
+      void appendQuoted(const std::string& text)
+      {
+        bytes.push_back('"');
+        for(size_t i = 0; i < text.size(); i++)
+        {
+          char c = text[i];
+          if(c == '"' || c == '\\')
+          {
+            bytes.push_back('\\');
+            bytes.push_back(c);
+          }
+          else if(c == '\n')
+            bytes.append("\\n", 2);
+          else if(static_cast<unsigned char>(c) < 0x20)
+          {
+            static const char hex[] = "0123456789abcdef";
+            char escaped[6] = {'\\', 'u', '0', '0', hex[(c >> 4) & 0xf], hex[c & 0xf]};
+            bytes.append(escaped, 6);
+          }
+          else
+            bytes.push_back(c);
+        }
+        bytes.push_back('"');
+      }
+
+      // appends a double quoted DOT string: Graphviz knows no \u escapes,
+      // so only quotes and backslashes are escaped and other bytes kept
+      void appendDotQuoted(const std::string& text)
+      {
+        bytes.push_back('"');
+        for(size_t i = 0; i < text.size(); i++)
+        {
+          if(text[i] == '"' || text[i] == '\\')
+            bytes.push_back('\\');
+          bytes.push_back(text[i]);
+        }
+        bytes.push_back('"');
+      }
+
+    private:
+      std::string bytes;
+    };
+
+  /**
+  * Function: formatInfo
+  * Description: turns the info of a vertex into text, strings and integers
+  *              directly and anything else through its operator<<
+  */
+  inline void formatInfo(const std::string& info, std::string& text)
+  {
+    text = info;
+  }
+
+  inline void formatInfo(const char* info, std::string& text)
+  {
+    text = info;
+  }
+
+  inline void formatInfo(long long info, std::string& text)
+  {
+    OutputBuffer digits;
+    digits.appendInt(info);
+    text.assign(digits.data(), digits.size());
+  }
+
+  inline void formatInfo(int info, std::string& text)
+  {
+    formatInfo(static_cast<long long>(info), text);
+  }
+
+  inline void formatInfo(long info, std::string& text)
+  {
+    formatInfo(static_cast<long long>(info), text);
+  }
+
+  template<class Type>
+  void formatInfo(const Type& info, std::string& text)
+  {
+    std::ostringstream stream;
+    stream << info;
+    text = stream.str();
+  }
+
+  /**
+  * Function: parseInfo
+  * Description: reads vertex info back from text, the inverse of
+  *              formatInfo: strings as they are, anything else through its
+  *              operator>>
+  * Function input: the text and the info to fill
+  * Function output: true if the whole text was read
+  */
+  template<class Type>
+  bool parseInfo(const std::string& text, Type& info)
+  {
+    std::istringstream stream(text);
+    return (stream >> info) && (stream >> std::ws).eof();
+  }
+
+  inline bool parseInfo(const std::string& text, std::string& info)
+  {
+    info = text;
+    return true;
+  }
+
+    enum ExportFormat{EDGE_LIST, DOT, JSON, BINARY};
+
+  /**
+  * Description: Writes graphs to streams. The vertices are cut into chunks;
+  * with more than one thread each thread formats a chunk into its own
+  * buffer and the buffers are written in chunk order, so the output is the
+  * same byte for byte whatever the number of threads. Buffers are kept
+  * between calls, so one writer should be reused for many exports.
+  *
+  * Anything with the iteration interface of Graph can be written, such as
+  * a FilteredView or a TemporalSnapshot; positions that hold no vertex
+  * are left out of the vertex lists and get no edges.
+  */
+    template<class Type>
+    class GraphWriter
+    {
+    public:
+
+    /**
+      * Function: GraphWriter - The overloaded constructor
+      * Description: Constructs a writer
+      * Function input: the number of threads (0 for all cores) and the
+      *                 number of vertices formatted per chunk
+      * Function output: None.
+      * Precondition: none.
+      * Postcondition: writer created
+      */
+      explicit GraphWriter(int threads = 1, int verticesPerChunk = 4096);
+
+    /**
+      * Function: write
+      * Description: writes a graph in the given format
+      * Function input: the graph, the stream and the format
+      * Function output: none
+      * Precondition: the stream should be opened in binary mode for BINARY
+      * Postcondition: the graph is written and the stream flushed
+      */
+      template<class GraphType>
+      void write(const GraphType& graph, std::ostream& out, ExportFormat format);
+
+    /**
+      * Function: writeEdgeList
+      * Description: writes one "from to weight" line per edge using vertex
+      *              positions, the weight is left out on UNWEIGHTED graphs
+      *              and undirected edges are written once
+      */
+      template<class GraphType>
+      void writeEdgeList(const GraphType& graph, std::ostream& out);
+
+    /**
+      * Function: writeDot
+      * Description: writes a Graphviz graph or digraph labelled with the
+      *              info of each vertex
+      */
+      template<class GraphType>
+      void writeDot(const GraphType& graph, std::ostream& out);
+
+    /**
+      * Function: writeJson
+      * Description: writes {"directed", "weighted", "vertices": [{"index",
+      *              "info"}], "edges": [{"from", "to", "weight"}]}
+      */
+      template<class GraphType>
+      void writeJson(const GraphType& graph, std::ostream& out);
+
+    /**
+      * Function: writeBinary
+      * Description: writes the adjacency lists in little endian: the magic
+      *              "GRAPHBIN", int32 flags (1 directed, 2 weighted), int32
+      *              position count, int64 entry count, then per position an int32
+      *              count followed by (int32 connIndex, int32 edgeWeight)
+      *              pairs. Vertex info is not written.
+      */
+      template<class GraphType>
+      void writeBinary(const GraphType& graph, std::ostream& out);
+
+    private:
+      /**
+      * Function: writeChunked
+      * Description: calls format(vertexIndex, buffer, scratch) for every
+      *              vertex and writes the buffers in vertex order
+      * Function output: whether anything was written
+      */
+      template<class GraphType, class Format>
+      bool writeChunked(const GraphType& graph, std::ostream& out, Format format, bool skipFirstByte);
+
+      int threads; // number of threads formatting chunks
+      int verticesPerChunk; // vertices formatted into one buffer
+      std::vector<OutputBuffer> chunks; // one buffer per thread, reused
+      std::vector<std::string> scratch; // one text scratch per thread, reused
+      OutputBuffer header; // text written before and after the chunks
+    };
+
+  template<class Type>
+  GraphWriter<Type>::GraphWriter(int threads, int verticesPerChunk)
+  {
+    this->threads = resolveThreadCount(threads, LLONG_MAX, 1);
+    this->verticesPerChunk = verticesPerChunk < 1 ? 1 : verticesPerChunk;
+    chunks.resize(this->threads);
+    scratch.resize(this->threads);
+  }
+
+  template<class Type>
+  template<class GraphType, class Format>
+  bool GraphWriter<Type>::writeChunked(const GraphType& graph, std::ostream& out, Format format, bool skipFirstByte)
+  {
+    int vertices = graph.positionCount();
+    bool wroteAny = false;
+    for(int roundBegin = 0; roundBegin < vertices; roundBegin += threads * verticesPerChunk)
+    {
+      int roundEnd = std::min(vertices, roundBegin + threads * verticesPerChunk);
+      int roundChunks = (roundEnd - roundBegin + verticesPerChunk - 1) / verticesPerChunk;
+      parallelFor(0, roundChunks, roundChunks, [&](long long first, long long last, int)
+      {
+        for(long long c = first; c < last; c++)
+        {
+          OutputBuffer& buffer = chunks[c];
+          buffer.clear();
+          int chunkBegin = roundBegin + static_cast<int>(c) * verticesPerChunk;
+          int chunkEnd = std::min(roundEnd, chunkBegin + verticesPerChunk);
+          for(int v = chunkBegin; v < chunkEnd; v++)
+            format(v, buffer, scratch[c]);
+        }
+      });
+
+      for(int c = 0; c < roundChunks; c++)
+      {
+        const OutputBuffer& buffer = chunks[c];
+        size_t skip = (skipFirstByte && !wroteAny && buffer.size() > 0) ? 1 : 0;
+        out.write(buffer.data() + skip, buffer.size() - skip);
+        wroteAny = wroteAny || buffer.size() > 0;
+      }
+    }
+    return wroteAny;
+  }
+
+  template<class Type>
+  template<class GraphType>
+  void GraphWriter<Type>::write(const GraphType& graph, std::ostream& out, ExportFormat format)
+  {
+    if(format == EDGE_LIST)
+      writeEdgeList(graph, out);
+    else if(format == DOT)
+      writeDot(graph, out);
+    else if(format == JSON)
+      writeJson(graph, out);
+    else
+      writeBinary(graph, out);
+  }
+
+  template<class Type>
+  template<class GraphType>
+  void GraphWriter<Type>::writeEdgeList(const GraphType& graph, std::ostream& out)
+  {
+    bool weighted = graph.weigh == WEIGHTED;
+    writeChunked(graph, out, [&](int v, OutputBuffer& buffer, std::string&)
+    {
+      forEachEdgeOnce(graph, v, [&](int connIndex, int edgeWeight)
+      {
+        buffer.appendInt(v);
+        buffer.append(' ');
+        buffer.appendInt(connIndex);
+        if(weighted)
+        {
+          buffer.append(' ');
+          buffer.appendInt(edgeWeight);
+        }
+        buffer.append('\n');
+      });
+    }, false);
+    out.flush();
+  }
+
+  template<class Type>
+  template<class GraphType>
+  void GraphWriter<Type>::writeDot(const GraphType& graph, std::ostream& out)
+  {
+    bool directed = graph.direction == DIRECTED;
+    bool weighted = graph.weigh == WEIGHTED;
+    const char* arrow = directed ? " -> " : " -- ";
+
+    header.clear();
+    header.append(directed ? "digraph G {\n" : "graph G {\n");
+    out.write(header.data(), header.size());
+
+    writeChunked(graph, out, [&](int v, OutputBuffer& buffer, std::string& text)
+    {
+      if(!graph.containsVertex(v))
+        return;
+      formatInfo(graph.infoAt(v), text);
+      buffer.append("  ");
+      buffer.appendInt(v);
+      buffer.append(" [label=");
+      buffer.appendDotQuoted(text);
+      buffer.append("];\n");
+      forEachEdgeOnce(graph, v, [&](int connIndex, int edgeWeight)
+      {
+        buffer.append("  ");
+        buffer.appendInt(v);
+        buffer.append(arrow, 4);
+        buffer.appendInt(connIndex);
+        if(weighted)
+        {
+          buffer.append(" [weight=");
+          buffer.appendInt(edgeWeight);
+          buffer.append(']');
+        }
+        buffer.append(";\n");
+      });
+    }, false);
+
+    out.write("}\n", 2);
+    out.flush();
+  }
+
+  template<class Type>
+  template<class GraphType>
+  void GraphWriter<Type>::writeJson(const GraphType& graph, std::ostream& out)
+  {
+    bool weighted = graph.weigh == WEIGHTED;
+
+    header.clear();
+    header.append("{\"directed\":");
+    header.append(graph.direction == DIRECTED ? "true" : "false");
+    header.append(",\"weighted\":");
+    header.append(weighted ? "true" : "false");
+    header.append(",\"vertices\":[");
+    out.write(header.data(), header.size());
+
+    // every item starts with a comma and the very first one is skipped
+    writeChunked(graph, out, [&](int v, OutputBuffer& buffer, std::string& text)
+    {
+      if(!graph.containsVertex(v))
+        return;
+      formatInfo(graph.infoAt(v), text);
+      buffer.append(",\n{\"index\":");
+      buffer.appendInt(v);
+      buffer.append(",\"info\":");
+      buffer.appendQuoted(text);
+      buffer.append('}');
+    }, true);
+
+    out.write("],\"edges\":[", 11);
+    writeChunked(graph, out, [&](int v, OutputBuffer& buffer, std::string&)
+    {
+      forEachEdgeOnce(graph, v, [&](int connIndex, int edgeWeight)
+      {
+        buffer.append(",\n{\"from\":");
+        buffer.appendInt(v);
+        buffer.append(",\"to\":");
+        buffer.appendInt(connIndex);
+        if(weighted)
+        {
+          buffer.append(",\"weight\":");
+          buffer.appendInt(edgeWeight);
+        }
+        buffer.append('}');
+      });
+    }, true);
+
+    out.write("]}\n", 3);
+    out.flush();
+  }
+
+  template<class Type>
+  template<class GraphType>
+  void GraphWriter<Type>::writeBinary(const GraphType& graph, std::ostream& out)
+  {
+    long long entries = 0;
+    for(int v = 0; v < graph.positionCount(); v++)
+      graph.forEachNeighbor(v, [&](int, int) { entries++; });
+
+    header.clear();
+    header.append("GRAPHBIN", 8);
+    header.appendInt32((graph.direction == DIRECTED ? 1 : 0) | (graph.weigh == WEIGHTED ? 2 : 0));
+    header.appendInt32(graph.positionCount());
+    header.appendInt64(entries);
+    out.write(header.data(), header.size());
+
+    writeChunked(graph, out, [&](int v, OutputBuffer& buffer, std::string&)
+    {
+      // the count goes before the entries and is filled in after them
+      size_t countAt = buffer.size();
+      int count = 0;
+      buffer.appendInt32(0);
+      graph.forEachNeighbor(v, [&](int connIndex, int edgeWeight)
+      {
+        buffer.appendInt32(connIndex);
+        buffer.appendInt32(edgeWeight);
+        count++;
+      });
+      buffer.patchInt32(countAt, count);
+    }, false);
+    out.flush();
+  }
+}
+#endif
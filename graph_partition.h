@@ -0,0 +1,609 @@
+#include "graph.h"
+#include <cmath>
+#include <unordered_map>
+#include <type_traits>
+#include <utility>
+
+/**
+ * File: graph_partition.h
+ * Description: This file contains the graph partitioners (streaming LDG and
+ *              Fennel, and a multilevel edge-cut partitioner), the
+ *              GraphShard structure that holds one part of a partitioned
+ *              graph together with its ghost vertices, and ShardBuilder,
+ *              which builds one shard from a stream of vertices and edges
+ *              without the whole graph in memory.
+ */
+
+#ifndef _GRAPH_PARTITION_H_
+#define _GRAPH_PARTITION_H_
+
+namespace GraphNameSpace
+{
+    enum PartitionMethod{LDG, FENNEL, MULTILEVEL};
+
+  /**
+  * Description: The shard that owns every vertex position
+  */
+    struct Partition
+    {
+      int shardCount; // number of shards
+      std::vector<int> owner; // shard owning each vertex position
+      long long cutEdges; // number of edges whose ends are owned by different shards
+    };
+
+  /**
+  * Description: One shard of a partitioned graph. Local indices
+  * [0, ownedCount) are the vertices this shard owns, the rest are ghosts:
+  * copies of vertices owned elsewhere that an owned vertex has an edge to.
+  * The adjacency lists of the owned vertices are complete and use local
+  * indices, ghosts have no adjacency list.
+  */
+    template<class Type>
+    struct GraphShard
+    {
+      int shardId; // which shard this is
+      int shardCount; // how many shards there are
+      int ownedCount; // number of owned vertices
+      Weight weigh; // weight of the partitioned graph
+      Direction direction; // direction of the partitioned graph
+      std::vector<int> globalIndex; // vertex position in the whole graph, per local index
+      std::unordered_map<int, int> localIndex; // local index of an owned or ghost vertex position
+      std::vector<int> ghostOwner; // owning shard of ghost ownedCount + i
+      std::vector<Type> info; // info of the owned vertices
+      std::vector<int> offset; // edges of owned vertex v are [offset[v], offset[v + 1])
+      std::vector<int> target; // local index at the other end of the edge
+      std::vector<int> weight; // weight of the edge
+    };
+
+  /**
+  * Description: Symmetric weighted adjacency used internally by the
+  * partitioners, with a weight per vertex so that coarsened graphs can be
+  * partitioned the same way as the original one
+  */
+    struct PartitionAdjacency
+    {
+      std::vector<int> offset; // neighbours of v are [offset[v], offset[v + 1])
+      std::vector<int> target; // the neighbour
+      std::vector<long long> weight; // number of original edges behind this one
+      std::vector<long long> vertexWeight; // number of original vertices behind this one
+
+      int size() const { return static_cast<int>(vertexWeight.size()); }
+
+      template<class GraphType>
+      static PartitionAdjacency fromGraph(const GraphType& graph)
+      {
+        int vertices = graph.positionCount();
+        bool symmetric = graph.direction == UNDIRECTED;
+        PartitionAdjacency adjacency;
+        adjacency.vertexWeight.assign(vertices, 1);
+        adjacency.offset.assign(vertices + 1, 0);
+        graph.forEachEdge([&](int from, int to, int)
+        {
+          if(from == to)
+            return;
+          adjacency.offset[from + 1]++;
+          if(!symmetric)
+            adjacency.offset[to + 1]++;
+        });
+        for(int v = 0; v < vertices; v++)
+          adjacency.offset[v + 1] += adjacency.offset[v];
+
+        adjacency.target.resize(adjacency.offset[vertices]);
+        adjacency.weight.assign(adjacency.offset[vertices], 1);
+        std::vector<int> next(adjacency.offset.begin(), adjacency.offset.end() - 1);
+        graph.forEachEdge([&](int from, int to, int)
+        {
+          if(from == to)
+            return;
+          adjacency.target[next[from]++] = to;
+          if(!symmetric)
+            adjacency.target[next[to]++] = from;
+        });
+        return adjacency;
+      }
+    };
+
+  /**
+  * Function: streamPartition
+  * Description: assigns the vertices one at a time in the given order. LDG
+  *              places a vertex where most of its neighbours already are,
+  *              scaled by how much room the shard has left; Fennel subtracts
+  *              a cost that grows with the shard size instead. No shard
+  *              takes more than slack times its fair share of vertex weight
+  *              while another one has room.
+  * Function input: the adjacency, the number of shards, LDG or FENNEL, the
+  *                 allowed imbalance and the order to stream the vertices in
+  * Function output: the shard of each vertex
+  */
+  inline std::vector<int> streamPartition(const PartitionAdjacency& graph, int parts, PartitionMethod method,
+                                          double slack, const std::vector<int>& streamOrder)
+  {
+    int vertices = graph.size();
+    long long totalWeight = 0;
+    long long heaviest = 1;
+    for(int v = 0; v < vertices; v++)
+    {
+      totalWeight += graph.vertexWeight[v];
+      heaviest = std::max(heaviest, graph.vertexWeight[v]);
+    }
+    double capacity = std::max(slack * totalWeight / parts, static_cast<double>(heaviest));
+
+    // Fennel's cost alpha * gamma * load^(gamma - 1) with gamma = 1.5
+    double edgeWeight = 0;
+    for(size_t e = 0; e < graph.weight.size(); e++)
+      edgeWeight += graph.weight[e];
+    double alpha = std::sqrt(static_cast<double>(parts)) * (edgeWeight / 2) /
+                   std::pow(std::max(1.0, static_cast<double>(totalWeight)), 1.5);
+    const double gamma = 1.5;
+
+    std::vector<int> owner(vertices, -1);
+    std::vector<double> load(parts, 0);
+    std::vector<double> together(parts, 0);
+    for(size_t i = 0; i < streamOrder.size(); i++)
+    {
+      int v = streamOrder[i];
+      for(int e = graph.offset[v]; e < graph.offset[v + 1]; e++)
+      {
+        int placed = owner[graph.target[e]];
+        if(placed != -1)
+          together[placed] += graph.weight[e];
+      }
+
+      int best = -1;
+      double bestScore = 0;
+      for(int p = 0; p < parts; p++)
+      {
+        if(load[p] + graph.vertexWeight[v] > capacity)
+          continue;
+        double score;
+        if(method == LDG)
+          score = together[p] * (1.0 - load[p] / capacity);
+        else
+          score = together[p] - alpha * gamma * std::sqrt(load[p]);
+        if(best == -1 || score > bestScore || (score == bestScore && load[p] < load[best]))
+        {
+          best = p;
+          bestScore = score;
+        }
+      }
+      if(best == -1)
+        best = static_cast<int>(std::min_element(load.begin(), load.end()) - load.begin());
+
+      owner[v] = best;
+      load[best] += graph.vertexWeight[v];
+      for(int e = graph.offset[v]; e < graph.offset[v + 1]; e++)
+      {
+        int placed = owner[graph.target[e]];
+        if(placed != -1)
+          together[placed] = 0;
+      }
+    }
+    return owner;
+  }
+
+  /**
+  * Function: coarsen
+  * Description: contracts a heavy-edge matching. Vertices are visited from
+  *              the lowest degree up and each unmatched one is merged with
+  *              the unmatched neighbour it shares the heaviest edge with.
+  * Function input: the fine adjacency and where to write the coarse vertex
+  *                 of every fine vertex
+  * Function output: the coarse adjacency with merged vertex and edge weights
+  */
+  inline PartitionAdjacency coarsen(const PartitionAdjacency& fine, std::vector<int>& coarseOf)
+  {
+    int vertices = fine.size();
+    std::vector<int> visitOrder(vertices);
+    for(int v = 0; v < vertices; v++)
+      visitOrder[v] = v;
+    std::stable_sort(visitOrder.begin(), visitOrder.end(), [&](int a, int b)
+    {
+      return fine.offset[a + 1] - fine.offset[a] < fine.offset[b + 1] - fine.offset[b];
+    });
+
+    coarseOf.assign(vertices, -1);
+    int coarseCount = 0;
+    for(int i = 0; i < vertices; i++)
+    {
+      int v = visitOrder[i];
+      if(coarseOf[v] != -1)
+        continue;
+      int mate = -1;
+      long long heaviest = 0;
+      for(int e = fine.offset[v]; e < fine.offset[v + 1]; e++)
+      {
+        int u = fine.target[e];
+        if(coarseOf[u] == -1 && u != v && fine.weight[e] > heaviest)
+        {
+          mate = u;
+          heaviest = fine.weight[e];
+        }
+      }
+      coarseOf[v] = coarseCount;
+      if(mate != -1)
+        coarseOf[mate] = coarseCount;
+      coarseCount++;
+    }
+
+    std::vector<std::vector<int> > members(coarseCount);
+    for(int v = 0; v < vertices; v++)
+      members[coarseOf[v]].push_back(v);
+
+    PartitionAdjacency coarse;
+    coarse.vertexWeight.assign(coarseCount, 0);
+    coarse.offset.assign(coarseCount + 1, 0);
+    std::vector<int> slotOf(coarseCount, -1);
+    for(int c = 0; c < coarseCount; c++)
+    {
+      int rowBegin = static_cast<int>(coarse.target.size());
+      for(size_t m = 0; m < members[c].size(); m++)
+      {
+        int v = members[c][m];
+        coarse.vertexWeight[c] += fine.vertexWeight[v];
+        for(int e = fine.offset[v]; e < fine.offset[v + 1]; e++)
+        {
+          int d = coarseOf[fine.target[e]];
+          if(d == c)
+            continue;
+          if(slotOf[d] == -1)
+          {
+            slotOf[d] = static_cast<int>(coarse.target.size());
+            coarse.target.push_back(d);
+            coarse.weight.push_back(0);
+          }
+          coarse.weight[slotOf[d]] += fine.weight[e];
+        }
+      }
+      for(size_t e = rowBegin; e < coarse.target.size(); e++)
+        slotOf[coarse.target[e]] = -1;
+      coarse.offset[c + 1] = static_cast<int>(coarse.target.size());
+    }
+    return coarse;
+  }
+
+  /**
+  * Function: refinePartition
+  * Description: greedy boundary refinement, moves a vertex to the shard it
+  *              has the most edge weight to when that lowers the cut and
+  *              the shard has room
+  * Function input: the adjacency, the shards so far, the number of shards,
+  *                 the allowed imbalance and the number of passes
+  * Function output: none
+  * Postcondition: the cut is no larger than before
+  */
+  inline void refinePartition(const PartitionAdjacency& graph, std::vector<int>& owner, int parts,
+                              double slack, int passes)
+  {
+    int vertices = graph.size();
+    std::vector<long long> load(parts, 0);
+    long long totalWeight = 0;
+    for(int v = 0; v < vertices; v++)
+    {
+      load[owner[v]] += graph.vertexWeight[v];
+      totalWeight += graph.vertexWeight[v];
+    }
+    double capacity = slack * totalWeight / parts;
+
+    std::vector<long long> connection(parts, 0);
+    for(int pass = 0; pass < passes; pass++)
+    {
+      bool moved = false;
+      for(int v = 0; v < vertices; v++)
+      {
+        int own = owner[v];
+        for(int e = graph.offset[v]; e < graph.offset[v + 1]; e++)
+          connection[owner[graph.target[e]]] += graph.weight[e];
+
+        int best = own;
+        for(int p = 0; p < parts; p++)
+        {
+          if(p != own && connection[p] > connection[best] && load[p] + graph.vertexWeight[v] <= capacity)
+            best = p;
+        }
+        for(int e = graph.offset[v]; e < graph.offset[v + 1]; e++)
+          connection[owner[graph.target[e]]] = 0;
+
+        if(best != own)
+        {
+          load[own] -= graph.vertexWeight[v];
+          load[best] += graph.vertexWeight[v];
+          owner[v] = best;
+          moved = true;
+        }
+      }
+      if(!moved)
+        break;
+    }
+  }
+
+  /**
+  * Function: partitionGraph
+  * Description: splits the vertex positions of a graph among shards. LDG
+  *              and FENNEL stream the vertices once in position order.
+  *              MULTILEVEL coarsens the graph by heavy-edge matching,
+  *              partitions the coarsest graph with LDG and refines the cut
+  *              while projecting back. Edge directions are ignored.
+  * Function input: the graph, the number of shards, the method and the
+  *                 allowed imbalance (1.0 is perfectly balanced)
+  * Function output: the shard of each position and the resulting edge cut
+  */
+  template<class GraphType>
+  Partition partitionGraph(const GraphType& graph, int shardCount, PartitionMethod method = FENNEL, double slack = 1.1)
+  {
+    Partition partition;
+    partition.shardCount = shardCount < 1 ? 1 : shardCount;
+    PartitionAdjacency adjacency = PartitionAdjacency::fromGraph(graph);
+
+    if(method != MULTILEVEL)
+    {
+      std::vector<int> streamOrder(adjacency.size());
+      for(int v = 0; v < adjacency.size(); v++)
+        streamOrder[v] = v;
+      partition.owner = streamPartition(adjacency, partition.shardCount, method, slack, streamOrder);
+    }
+    else
+    {
+      std::vector<PartitionAdjacency> levels(1, adjacency);
+      std::vector<std::vector<int> > coarseOf;
+      int smallEnough = std::max(64, 16 * partition.shardCount);
+      while(levels.back().size() > smallEnough)
+      {
+        coarseOf.push_back(std::vector<int>());
+        PartitionAdjacency coarse = coarsen(levels.back(), coarseOf.back());
+        if(coarse.size() > levels.back().size() * 9 / 10)
+        {
+          coarseOf.pop_back();
+          break;
+        }
+        levels.push_back(coarse);
+      }
+
+      // heaviest coarse vertices first so that they can still be balanced
+      const PartitionAdjacency& coarsest = levels.back();
+      std::vector<int> streamOrder(coarsest.size());
+      for(int v = 0; v < coarsest.size(); v++)
+        streamOrder[v] = v;
+      std::stable_sort(streamOrder.begin(), streamOrder.end(), [&](int a, int b)
+      {
+        return coarsest.vertexWeight[a] > coarsest.vertexWeight[b];
+      });
+      std::vector<int> owner = streamPartition(coarsest, partition.shardCount, LDG, slack, streamOrder);
+      refinePartition(coarsest, owner, partition.shardCount, slack, 8);
+
+      for(int level = static_cast<int>(coarseOf.size()) - 1; level >= 0; level--)
+      {
+        std::vector<int> finer(coarseOf[level].size());
+        for(size_t v = 0; v < finer.size(); v++)
+          finer[v] = owner[coarseOf[level][v]];
+        owner.swap(finer);
+        refinePartition(levels[level], owner, partition.shardCount, slack, 4);
+      }
+      partition.owner = owner;
+    }
+
+    partition.cutEdges = 0;
+    graph.forEachEdge([&](int from, int to, int)
+    {
+      if(partition.owner[from] != partition.owner[to])
+        partition.cutEdges++;
+    });
+    if(graph.direction == UNDIRECTED)
+      partition.cutEdges /= 2;
+    return partition;
+  }
+
+  /**
+  * Description: Builds one shard from a stream of vertices and edges, in
+  * any order, keeping only what the shard needs: its owned vertices and
+  * the edges touching them. Memory is that of the shard plus the owner
+  * table of the partition (4 bytes per vertex), so each process of a
+  * cluster can build its own shard from the same edge files.
+  */
+    template<class Type>
+    class ShardBuilder
+    {
+    public:
+
+    /**
+      * Function: ShardBuilder - The overloaded constructor
+      * Description: Constructs a builder for one shard
+      * Function input: the shard id, the partition, and the weight and
+      *                 direction of the graph
+      * Function output: None.
+      * Precondition: the partition outlives the builder
+      * Postcondition: the builder holds nothing yet
+      */
+      ShardBuilder(int shardId, const Partition& partition, Weight weigh, Direction direction);
+
+    /**
+      * Function: addVertex
+      * Description: adds a vertex, kept if the shard owns it
+      * Function input: its position in the whole graph and its info
+      */
+      void addVertex(int vertexIndex, const Type& info);
+
+    /**
+      * Function: addEdge
+      * Description: adds an edge, kept from each end the shard owns. An
+      *              undirected edge is added once and becomes an entry on
+      *              both ends, as in Graph.
+      * Function input: the positions of its ends and its weight
+      */
+      void addEdge(int fromIndex, int toIndex, int edgeWeight);
+
+    /**
+      * Function: finish
+      * Description: lays out the shard: owned vertices by position, each
+      *              adjacency list in the order its edges were added, ghosts
+      *              in order of first use
+      * Function input: none
+      * Function output: the shard
+      * Precondition: every owned vertex was added; edges of vertices that
+      *               weren't are dropped
+      * Postcondition: the builder is empty
+      */
+      GraphShard<Type> finish();
+
+    private:
+      struct Entry
+      {
+        int fromIndex; // position of the owned end
+        int toIndex; // position of the other end
+        int edgeWeight;
+      };
+
+      int shardId;
+      const Partition& partition;
+      Weight weigh;
+      Direction direction;
+      std::vector<std::pair<int, Type> > owned; // position and info of the owned vertices
+      std::vector<Entry> entries; // adjacency entries of owned vertices
+    };
+
+  template<class Type>
+  ShardBuilder<Type>::ShardBuilder(int shardId, const Partition& partition, Weight weigh, Direction direction)
+    : shardId(shardId), partition(partition), weigh(weigh), direction(direction)
+  {
+  }
+
+  template<class Type>
+  void ShardBuilder<Type>::addVertex(int vertexIndex, const Type& info)
+  {
+    if(partition.owner[vertexIndex] == shardId)
+      owned.push_back(std::make_pair(vertexIndex, info));
+  }
+
+  template<class Type>
+  void ShardBuilder<Type>::addEdge(int fromIndex, int toIndex, int edgeWeight)
+  {
+    if(partition.owner[fromIndex] == shardId)
+    {
+      Entry entry = {fromIndex, toIndex, edgeWeight};
+      entries.push_back(entry);
+    }
+    if(direction == UNDIRECTED && partition.owner[toIndex] == shardId)
+    {
+      Entry entry = {toIndex, fromIndex, edgeWeight};
+      entries.push_back(entry);
+    }
+  }
+
+  template<class Type>
+  GraphShard<Type> ShardBuilder<Type>::finish()
+  {
+    GraphShard<Type> shard;
+    shard.shardId = shardId;
+    shard.shardCount = partition.shardCount;
+    shard.weigh = weigh;
+    shard.direction = direction;
+
+    std::sort(owned.begin(), owned.end(), [](const std::pair<int, Type>& a, const std::pair<int, Type>& b)
+    {
+      return a.first < b.first;
+    });
+    for(size_t i = 0; i < owned.size(); i++)
+    {
+      shard.localIndex[owned[i].first] = static_cast<int>(i);
+      shard.globalIndex.push_back(owned[i].first);
+      shard.info.push_back(owned[i].second);
+    }
+    shard.ownedCount = static_cast<int>(owned.size());
+
+    // counting sort of the entries by owned vertex, keeping the order they came in
+    shard.offset.assign(shard.ownedCount + 1, 0);
+    std::vector<int> local(entries.size(), -1);
+    for(size_t e = 0; e < entries.size(); e++)
+    {
+      std::unordered_map<int, int>::const_iterator found = shard.localIndex.find(entries[e].fromIndex);
+      if(found == shard.localIndex.end())
+        continue;
+      local[e] = found->second;
+      shard.offset[found->second + 1]++;
+    }
+    for(int v = 0; v < shard.ownedCount; v++)
+      shard.offset[v + 1] += shard.offset[v];
+    std::vector<int> sorted(shard.offset[shard.ownedCount]);
+    std::vector<int> next(shard.offset.begin(), shard.offset.end() - 1);
+    for(size_t e = 0; e < entries.size(); e++)
+    {
+      if(local[e] != -1)
+        sorted[next[local[e]]++] = static_cast<int>(e);
+    }
+
+    shard.target.resize(sorted.size());
+    shard.weight.resize(sorted.size());
+    for(size_t i = 0; i < sorted.size(); i++)
+    {
+      const Entry& entry = entries[sorted[i]];
+      std::unordered_map<int, int>::iterator found = shard.localIndex.find(entry.toIndex);
+      int target;
+      if(found != shard.localIndex.end())
+        target = found->second;
+      else
+      {
+        target = static_cast<int>(shard.globalIndex.size());
+        shard.localIndex[entry.toIndex] = target;
+        shard.globalIndex.push_back(entry.toIndex);
+        shard.ghostOwner.push_back(partition.owner[entry.toIndex]);
+      }
+      shard.target[i] = target;
+      shard.weight[i] = entry.edgeWeight;
+    }
+
+    std::vector<std::pair<int, Type> >().swap(owned);
+    std::vector<Entry>().swap(entries);
+    return shard;
+  }
+
+  /**
+  * Description: The info type of anything with the Graph iteration interface
+  */
+  template<class GraphType>
+  struct GraphInfoType
+  {
+    typedef typename std::decay<decltype(std::declval<const GraphType&>().infoAt(0))>::type type;
+  };
+
+  /**
+  * Function: buildShards
+  * Description: splits a graph into one GraphShard per shard of a partition,
+  *              each holding its owned vertices, their complete adjacency
+  *              lists and a ghost table for the vertices on the far end of
+  *              edges that leave the shard. Works on anything with the
+  *              Graph iteration interface (Graph, FilteredView,
+  *              TemporalSnapshot); for graphs that don't fit in one process
+  *              use a ShardBuilder per process instead.
+  * Function input: the graph and its partition
+  * Function output: the shards, indexed by shard id
+  */
+  template<class GraphType>
+  std::vector<GraphShard<typename GraphInfoType<GraphType>::type> > buildShards(const GraphType& graph, const Partition& partition)
+  {
+    typedef typename GraphInfoType<GraphType>::type Type;
+    std::vector<ShardBuilder<Type> > builders;
+    for(int s = 0; s < partition.shardCount; s++)
+      builders.push_back(ShardBuilder<Type>(s, partition, graph.weigh, graph.direction));
+
+    graph.forEachVertex([&](int vertexIndex, const Type& info)
+    {
+      builders[partition.owner[vertexIndex]].addVertex(vertexIndex, info);
+    });
+    for(int v = 0; v < graph.positionCount(); v++)
+    {
+      int from = partition.owner[v];
+      forEachEdgeOnce(graph, v, [&](int connIndex, int edgeWeight)
+      {
+        builders[from].addEdge(v, connIndex, edgeWeight);
+        int to = partition.owner[connIndex];
+        if(graph.direction == UNDIRECTED && to != from)
+          builders[to].addEdge(v, connIndex, edgeWeight);
+      });
+    }
+
+    std::vector<GraphShard<Type> > shards;
+    for(int s = 0; s < partition.shardCount; s++)
+      shards.push_back(builders[s].finish());
+    return shards;
+  }
+}
+#endif
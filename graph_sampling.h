@@ -0,0 +1,385 @@
+#include "graph.h"
+
+/**
+ * File: graph_sampling.h
+ * Description: This file contains the random walk and neighbour sampling
+ *              engine: a compact copy of the adjacency lists with alias
+ *              tables for weighted graphs, uniform and node2vec walks and
+ *              GraphSAGE style neighbour samples, all written into buffers
+ *              the caller allocates.
+ */
+
+#ifndef _GRAPH_SAMPLING_H_
+#define _GRAPH_SAMPLING_H_
+
+namespace GraphNameSpace
+{
+  /**
+  * Description: A small and fast random number generator (xoshiro256**).
+  * Every walk or sample gets its own generator seeded from the caller's seed
+  * and its row number, so the output doesn't depend on the thread count.
+  */
+    class FastRandom
+    {
+    public:
+      explicit FastRandom(unsigned long long seed)
+      {
+        for(int i = 0; i < 4; i++)
+        {
+          seed = mixHash64(seed);
+          state[i] = seed;
+        }
+      }
+
+      unsigned long long next()
+      {
+        unsigned long long result = rotate(state[1] * 5, 7) * 9;
+        unsigned long long shifted = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= shifted;
+        state[3] = rotate(state[3], 45);
+        return result;
+      }
+
+      // a number in [0, range), by multiplying instead of dividing
+      unsigned bounded(unsigned range)
+      {
+        return static_cast<unsigned>(((next() >> 32) * range) >> 32);
+      }
+
+      // a number in [0, 1)
+      double uniform()
+      {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+      }
+
+    private:
+      static unsigned long long rotate(unsigned long long value, int bits)
+      {
+        return (value << bits) | (value >> (64 - bits));
+      }
+
+      unsigned long long state[4];
+    };
+
+  /**
+  * Description: Walks and neighbour samples over a copy of a graph's
+  * adjacency lists. Each vertex's neighbours are stored contiguously and
+  * sorted by position. On a weighted graph a step picks an edge with
+  * probability proportional to its weight through an alias table, in
+  * constant time; edges of weight 0 or less are never picked, and a vertex
+  * whose edges all weigh 0 picks uniformly. Vertices are named by their
+  * position in the graph, which handleAt/positionOf translate. Works on
+  * anything with the Graph iteration interface (Graph, FilteredView,
+  * TemporalSnapshot) and doesn't see later changes to it.
+  */
+    class WalkEngine
+    {
+    public:
+
+    /**
+      * Function: WalkEngine - The overloaded constructor with a graph
+      * Description: copies the adjacency lists and builds the alias tables
+      * Function input: the graph and the number of threads (0 for all cores)
+      * Function output: None.
+      * Precondition: none.
+      * Postcondition: the engine is ready to sample
+      */
+      template<class GraphType>
+      explicit WalkEngine(const GraphType& graph, int threads = 0);
+
+    /**
+      * Function: positionCount / degree
+      * Description: the number of positions, and the number of edges out of one
+      */
+      int positionCount() const { return static_cast<int>(present.size()); }
+      int degree(int vertexIndex) const { return static_cast<int>(offset[vertexIndex + 1] - offset[vertexIndex]); }
+
+    /**
+      * Function: randomWalks
+      * Description: walks from every start vertex, each step moving to a
+      *              neighbour picked at random (by weight if weighted).
+      *              Walk w from starts[s] is row s * walksPerStart + w of
+      *              out; its first entry is the start vertex.
+      * Function input: the start positions, walks per start, vertices per
+      *                 walk, the output buffer, a seed and the number of threads
+      * Function output: none
+      * Precondition: out holds starts.size() * walksPerStart * length ints
+      * Postcondition: out is filled, a walk reaching a vertex without edges
+      *                (or starting at an empty position) is padded with -1
+      */
+      void randomWalks(const std::vector<int>& starts, int walksPerStart, int length, int* out,
+                       unsigned long long seed, int threads = 0) const;
+
+    /**
+      * Function: node2vecWalks
+      * Description: like randomWalks, with steps biased by where the walk
+      *              came from: going back is weighted 1/returnBias, moving
+      *              to a neighbour of the previous vertex 1, and moving
+      *              further away 1/inOutBias (the p and q of node2vec)
+      * Function input: as randomWalks, plus p and q
+      * Function output: none
+      * Precondition: p and q are positive
+      * Postcondition: out is filled as by randomWalks
+      */
+      void node2vecWalks(const std::vector<int>& starts, int walksPerStart, int length, double returnBias,
+                         double inOutBias, int* out, unsigned long long seed, int threads = 0) const;
+
+    /**
+      * Function: sampleNeighbors
+      * Description: picks fanout neighbours of each vertex at random, with
+      *              replacement, as GraphSAGE does for one layer. Row i of
+      *              out belongs to nodes[i]; the rows of one layer are the
+      *              nodes of the next.
+      * Function input: the vertex positions, neighbours per vertex, the
+      *                 output buffer, a seed and the number of threads
+      * Function output: none
+      * Precondition: out holds nodes.size() * fanout ints
+      * Postcondition: out is filled, rows of vertices without edges hold -1
+      */
+      void sampleNeighbors(const std::vector<int>& nodes, int fanout, int* out,
+                           unsigned long long seed, int threads = 0) const;
+
+    private:
+      /**
+      * Function: pickEdge
+      * Description: picks one edge out of a vertex with edges, returns its index in target
+      */
+      long long pickEdge(int vertexIndex, FastRandom& random) const;
+
+      /**
+      * Function: hasEdge
+      * Description: binary search for an edge between two positions
+      */
+      bool hasEdge(int fromIndex, int toIndex) const;
+
+      /**
+      * Function: buildAliasTable
+      * Description: Vose's alias method over the edges of one vertex
+      */
+      void buildAliasTable(int vertexIndex);
+
+      /**
+      * Function: walk
+      * Description: walks over rows [first, last) of the output, the bias
+      *              callable accepts or rejects a step from previous through
+      *              current to next
+      */
+      template<class Bias>
+      void walk(const std::vector<int>& starts, int walksPerStart, int length, int* out,
+                unsigned long long seed, long long first, long long last, Bias accept) const;
+
+      std::vector<char> present; // 1 if the position holds a vertex
+      std::vector<long long> offset; // edges of v are [offset[v], offset[v + 1])
+      std::vector<int> target; // the neighbour, sorted within each vertex
+      std::vector<int> weight; // the weight of the edge
+      std::vector<double> probability; // alias table: keep the edge with this probability
+      std::vector<int> alias; // alias table: otherwise take this edge of the same vertex
+      bool weighted; // are the alias tables in use?
+    };
+
+  template<class GraphType>
+  WalkEngine::WalkEngine(const GraphType& graph, int threads)
+    : weighted(graph.weigh == WEIGHTED)
+  {
+    int vertices = graph.positionCount();
+    present.assign(vertices, 0);
+    offset.assign(vertices + 1, 0);
+    for(int v = 0; v < vertices; v++)
+    {
+      if(graph.containsVertex(v))
+        present[v] = 1;
+    }
+    graph.forEachEdge([&](int from, int, int)
+    {
+      offset[from + 1]++;
+    });
+    for(int v = 0; v < vertices; v++)
+      offset[v + 1] += offset[v];
+    target.resize(offset[vertices]);
+    weight.resize(offset[vertices]);
+
+    threads = resolveThreadCount(threads, offset[vertices]);
+    parallelFor(0, vertices, threads, [&](long long first, long long last, int)
+    {
+      std::vector<std::pair<int, int> > edges;
+      for(long long v = first; v < last; v++)
+      {
+        edges.clear();
+        graph.forEachNeighbor(static_cast<int>(v), [&](int connIndex, int edgeWeight)
+        {
+          edges.push_back(std::make_pair(connIndex, edgeWeight));
+        });
+        std::sort(edges.begin(), edges.end());
+        for(size_t e = 0; e < edges.size(); e++)
+        {
+          target[offset[v] + e] = edges[e].first;
+          weight[offset[v] + e] = edges[e].second;
+        }
+      }
+    });
+
+    if(weighted)
+    {
+      probability.resize(offset[vertices]);
+      alias.resize(offset[vertices]);
+      parallelFor(0, vertices, threads, [&](long long first, long long last, int)
+      {
+        for(long long v = first; v < last; v++)
+          buildAliasTable(static_cast<int>(v));
+      });
+    }
+  }
+
+  inline void WalkEngine::buildAliasTable(int vertexIndex)
+  {
+    long long begin = offset[vertexIndex];
+    int edges = degree(vertexIndex);
+    double total = 0;
+    for(int e = 0; e < edges; e++)
+      total += std::max(weight[begin + e], 0);
+
+    std::vector<int> small;
+    std::vector<int> large;
+    for(int e = 0; e < edges; e++)
+    {
+      // scaled so the average edge has probability 1
+      probability[begin + e] = total > 0 ? std::max(weight[begin + e], 0) * edges / total : 1.0;
+      alias[begin + e] = e;
+      if(probability[begin + e] < 1.0)
+        small.push_back(e);
+      else
+        large.push_back(e);
+    }
+    while(!small.empty() && !large.empty())
+    {
+      int less = small.back();
+      int more = large.back();
+      small.pop_back();
+      alias[begin + less] = more;
+      probability[begin + more] -= 1.0 - probability[begin + less];
+      if(probability[begin + more] < 1.0)
+      {
+        large.pop_back();
+        small.push_back(more);
+      }
+    }
+    // whatever is left is 1 up to rounding
+    for(size_t i = 0; i < small.size(); i++)
+      probability[begin + small[i]] = 1.0;
+    for(size_t i = 0; i < large.size(); i++)
+      probability[begin + large[i]] = 1.0;
+  }
+
+  inline long long WalkEngine::pickEdge(int vertexIndex, FastRandom& random) const
+  {
+    long long begin = offset[vertexIndex];
+    long long e = begin + random.bounded(static_cast<unsigned>(degree(vertexIndex)));
+    if(weighted && random.uniform() >= probability[e])
+      e = begin + alias[e];
+    return e;
+  }
+
+  inline bool WalkEngine::hasEdge(int fromIndex, int toIndex) const
+  {
+    return std::binary_search(target.begin() + offset[fromIndex], target.begin() + offset[fromIndex + 1], toIndex);
+  }
+
+  template<class Bias>
+  void WalkEngine::walk(const std::vector<int>& starts, int walksPerStart, int length, int* out,
+                        unsigned long long seed, long long first, long long last, Bias accept) const
+  {
+    for(long long row = first; row < last; row++)
+    {
+      FastRandom random(seed ^ mixHash64(static_cast<unsigned long long>(row)));
+      int* path = out + row * length;
+      int current = starts[row / walksPerStart];
+      int previous = -1;
+      int step = 0;
+      if(current >= 0 && current < positionCount() && present[current])
+      {
+        path[step++] = current;
+        while(step < length && degree(current) > 0)
+        {
+          int next = target[pickEdge(current, random)];
+          while(!accept(previous, next, random))
+            next = target[pickEdge(current, random)];
+          path[step++] = next;
+          previous = current;
+          current = next;
+        }
+      }
+      for( ; step < length; step++)
+        path[step] = -1;
+    }
+  }
+
+  inline void WalkEngine::randomWalks(const std::vector<int>& starts, int walksPerStart, int length, int* out,
+                                      unsigned long long seed, int threads) const
+  {
+    long long rows = static_cast<long long>(starts.size()) * walksPerStart;
+    if(rows == 0 || length <= 0)
+      return;
+    threads = resolveThreadCount(threads, rows * length);
+    parallelFor(0, rows, threads, [&](long long first, long long last, int)
+    {
+      walk(starts, walksPerStart, length, out, seed, first, last, [](int, int, FastRandom&)
+      {
+        return true;
+      });
+    });
+  }
+
+  inline void WalkEngine::node2vecWalks(const std::vector<int>& starts, int walksPerStart, int length, double returnBias,
+                                        double inOutBias, int* out, unsigned long long seed, int threads) const
+  {
+    long long rows = static_cast<long long>(starts.size()) * walksPerStart;
+    if(rows == 0 || length <= 0)
+      return;
+    // rejection sampling: a step proposed by the first order walk is kept
+    // with probability its bias over the largest bias
+    double back = 1.0 / returnBias;
+    double away = 1.0 / inOutBias;
+    double largest = std::max(1.0, std::max(back, away));
+    back /= largest;
+    away /= largest;
+    double near = 1.0 / largest;
+
+    threads = resolveThreadCount(threads, rows * length);
+    parallelFor(0, rows, threads, [&](long long first, long long last, int)
+    {
+      walk(starts, walksPerStart, length, out, seed, first, last, [&](int previous, int next, FastRandom& random)
+      {
+        if(previous == -1)
+          return true;
+        double keep = next == previous ? back : (hasEdge(previous, next) ? near : away);
+        return keep >= 1.0 || random.uniform() < keep;
+      });
+    });
+  }
+
+  inline void WalkEngine::sampleNeighbors(const std::vector<int>& nodes, int fanout, int* out,
+                                          unsigned long long seed, int threads) const
+  {
+    long long rows = static_cast<long long>(nodes.size());
+    if(rows == 0 || fanout <= 0)
+      return;
+    threads = resolveThreadCount(threads, rows * fanout);
+    parallelFor(0, rows, threads, [&](long long first, long long last, int)
+    {
+      for(long long row = first; row < last; row++)
+      {
+        FastRandom random(seed ^ mixHash64(static_cast<unsigned long long>(row)));
+        int* sample = out + row * fanout;
+        int vertex = nodes[row];
+        bool hasEdges = vertex >= 0 && vertex < positionCount() && degree(vertex) > 0;
+        for(int s = 0; s < fanout; s++)
+          sample[s] = hasEdges ? target[pickEdge(vertex, random)] : -1;
+      }
+    });
+  }
+}
+#endif
@@ -0,0 +1,842 @@
+#include "graph_export.h"
+#include <string>
+#include <sstream>
+#include <chrono>
+#include <mutex>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/**
+ * File: graph_server.h
+ * Description: This file contains an embedded query server that answers
+ *              adjacency, edge weight and breadth first distance queries
+ *              about a Graph over a Unix domain socket, and a small blocking
+ *              client to talk to it.
+ *
+ *              The protocol is one request per line, one response line per
+ *              request, in order:
+ *                ADJ <from> <to>     -> 1 or 0
+ *                WEIGHT <from> <to>  -> the weight, -1 if there is no edge
+ *                BFS <from> <to>     -> edges on a shortest path, -1 if unreachable
+ *                STATS               -> the server metrics as key=value pairs
+ *              Errors are answered with a line starting with ERR. Vertices
+ *              are read with operator>> (strings as single words).
+ */
+
+#ifndef _GRAPH_SERVER_H_
+#define _GRAPH_SERVER_H_
+
+namespace GraphNameSpace
+{
+  /**
+  * Description: Counters kept by a QueryServer. Latency is measured from
+  * reading a request to queueing its answer.
+  */
+    struct ServerMetrics
+    {
+      static const int LATENCY_BUCKETS = 32;
+
+      long long requests; // requests answered
+      long long batches; // batches executed
+      long long largestBatch; // most requests answered by one batch
+      long long queueDepth; // requests read and not yet answered
+      long long maxQueueDepth; // most requests ever waiting at once
+      long long connections; // clients connected now
+      long long totalLatencyMicros; // summed over all requests
+      long long maxLatencyMicros; // slowest request
+      long long latencyHistogram[LATENCY_BUCKETS]; // bucket b counts latencies below 2^b microseconds and not below 2^(b-1)
+
+      double meanLatencyMicros() const
+      {
+        return requests > 0 ? static_cast<double>(totalLatencyMicros) / requests : 0;
+      }
+
+      // upper bound of the bucket holding the given fraction of requests, at most the slowest
+      long long latencyPercentileMicros(double fraction) const
+      {
+        long long seen = 0;
+        for(int b = 0; b < LATENCY_BUCKETS; b++)
+        {
+          seen += latencyHistogram[b];
+          if(seen > 0 && seen >= fraction * requests)
+            return std::min(1LL << b, maxLatencyMicros);
+        }
+        return maxLatencyMicros;
+      }
+    };
+
+  /**
+  * Description: A server answering queries about a graph on a Unix domain
+  * socket. One thread runs an epoll loop over non-blocking sockets, each
+  * connection being a small state machine that collects request lines and
+  * drains its answers. Requests read in the same round of the loop, from
+  * any connection, are answered together as a batch: adjacency and weight
+  * queries are grouped by source vertex so each adjacency list is scanned
+  * once per batch, and breadth first searches from the same source are run
+  * once, different sources in parallel.
+  *
+  * The server reads the graph between batches only; pause() holds it off
+  * while the application changes the graph.
+  *
+  * A client that sends requests without reading the answers stops being
+  * read once MAX_PENDING bytes of answers wait for it, and is read again
+  * when they drain, so it can't make the server buffer without bound.
+  */
+    template<class Type>
+    class QueryServer
+    {
+    public:
+
+    /**
+      * Function: QueryServer - The overloaded constructor with a graph
+      * Description: Constructs a server that isn't listening yet
+      * Function input: the graph, the socket path, the most requests per
+      *                 batch and the threads for searches (0 for all cores)
+      * Function output: None.
+      * Precondition: the graph outlives the server
+      * Postcondition: the server is ready to start
+      */
+      QueryServer(const Graph<Type>& graph, const std::string& socketPath, int maxBatch = 4096, int threads = 0);
+
+      ~QueryServer();
+
+    /**
+      * Function: start
+      * Description: binds the socket and starts the loop thread
+      * Function input: none
+      * Function output: true if the server is listening
+      * Precondition: the server isn't running
+      * Postcondition: clients may connect, errors are printed
+      */
+      bool start() throw (std::logic_error);
+
+    /**
+      * Function: stop
+      * Description: stops the loop thread, closes every connection and
+      *              removes the socket
+      * Function input: none
+      * Function output: none
+      * Precondition: none
+      * Postcondition: the server isn't running
+      */
+      void stop();
+
+    /**
+      * Function: pause
+      * Description: keeps the server from reading the graph for as long
+      *              as the returned lock is held
+      */
+      std::unique_lock<std::mutex> pause();
+
+    /**
+      * Function: metrics
+      * Description: returns a copy of the server counters
+      */
+      ServerMetrics metrics() const;
+
+    private:
+      QueryServer(const QueryServer&);
+      QueryServer& operator=(const QueryServer&);
+
+      typedef std::chrono::steady_clock Clock;
+
+      static const size_t MAX_LINE = 1 << 16; // longest request line
+      static const size_t MAX_PENDING = 1 << 20; // answers held for a client before it stops being read
+
+      enum QueryKind {ADJACENT, WEIGHT, DISTANCE, STATS, MALFORMED};
+
+      struct Connection
+      {
+        std::string input; // bytes read, not yet a whole line
+        std::string output; // answers not yet written
+        unsigned watched; // events registered with epoll
+        bool closing; // has the client hung up?
+        bool held; // stopped reading until its answers drain
+      };
+
+      struct Request
+      {
+        int client; // socket of the connection
+        QueryKind kind;
+        std::string fromWord, toWord; // the vertices as sent
+        int fromIndex, toIndex; // their positions, -1 if unknown
+        long long answer;
+        const char* error; // set if the request can't be answered
+        Clock::time_point received;
+      };
+
+      void run();
+      void closeAll();
+      void acceptClients();
+      void readFrom(int client);
+      void parseLine(int client, const std::string& line, Clock::time_point now);
+      void executeBatch();
+      void answerEdges(const std::vector<int>& indices);
+      void answerDistances(const std::vector<int>& indices);
+      void flush(int client);
+      void watch(int client);
+      void closeClient(int client);
+      std::string formatMetrics() const;
+
+      const Graph<Type>& graph; // the graph being served
+      std::string socketPath;
+      int maxBatch; // most requests in one batch
+      int threads; // threads for searches
+      int listenSocket, epollFd, wakeFd; // -1 when closed
+      std::thread loop; // the event loop
+      std::unordered_map<int, Connection> clients; // by socket
+      std::vector<Request> batch; // requests waiting to be answered
+      std::vector<long long> stamp; // scratch for answerEdges, the group that last saw a position
+      std::vector<int> stampWeight; // scratch for answerEdges, the weight it saw
+      long long stampGroup; // groups handled by answerEdges
+      std::mutex graphLock; // held while a batch reads the graph
+      mutable std::mutex metricsLock; // guards counters
+      ServerMetrics counters;
+    };
+
+  /**
+  * Description: A blocking client for a QueryServer. Requests can be sent
+  * one at a time with query, or pipelined with send and receive.
+  */
+    class QueryClient
+    {
+    public:
+      QueryClient() : socketFd(-1) {}
+      ~QueryClient() { disconnect(); }
+
+    /**
+      * Function: connect
+      * Description: connects to a server
+      * Function input: the socket path
+      * Function output: true if connected, errors are printed
+      */
+      bool connect(const std::string& socketPath) throw (std::logic_error)
+      {
+        disconnect();
+        try
+        {
+          if(socketPath.size() >= sizeof(sockaddr_un().sun_path))
+            throw std::logic_error("Socket path is too long. Couldn't connect");
+          socketFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+          if(socketFd == -1)
+            throw std::logic_error(std::string("Couldn't create socket: ") + std::strerror(errno));
+          sockaddr_un address;
+          std::memset(&address, 0, sizeof(address));
+          address.sun_family = AF_UNIX;
+          std::strcpy(address.sun_path, socketPath.c_str());
+          if(::connect(socketFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1)
+            throw std::logic_error(std::string("Couldn't connect: ") + std::strerror(errno));
+        }
+        catch(const std::logic_error& bad_item)
+        {
+          cerr << "logic_error: " << bad_item.what() << '\n';
+          disconnect();
+          return false;
+        }
+        return true;
+      }
+
+      void disconnect()
+      {
+        if(socketFd != -1)
+          ::close(socketFd);
+        socketFd = -1;
+        pending.clear();
+      }
+
+    /**
+      * Function: send
+      * Description: sends one request line without waiting for the answer
+      * Function output: false if the connection failed
+      */
+      bool send(const std::string& request)
+      {
+        std::string line = request + '\n';
+        size_t sent = 0;
+        while(sent < line.size())
+        {
+          ssize_t written = ::send(socketFd, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+          if(written <= 0)
+          {
+            if(written == -1 && errno == EINTR)
+              continue;
+            return false;
+          }
+          sent += written;
+        }
+        return true;
+      }
+
+    /**
+      * Function: receive
+      * Description: waits for the next answer line
+      * Function output: the line without its newline, empty if the
+      *                  connection closed
+      */
+      std::string receive()
+      {
+        size_t end;
+        while((end = pending.find('\n')) == std::string::npos)
+        {
+          char buffer[4096];
+          ssize_t got = ::recv(socketFd, buffer, sizeof(buffer), 0);
+          if(got <= 0)
+          {
+            if(got == -1 && errno == EINTR)
+              continue;
+            return std::string();
+          }
+          pending.append(buffer, got);
+        }
+        std::string line = pending.substr(0, end);
+        pending.erase(0, end + 1);
+        return line;
+      }
+
+    /**
+      * Function: query
+      * Description: sends a request and waits for its answer
+      */
+      std::string query(const std::string& request)
+      {
+        return send(request) ? receive() : std::string();
+      }
+
+    private:
+      QueryClient(const QueryClient&);
+      QueryClient& operator=(const QueryClient&);
+
+      int socketFd; // -1 when not connected
+      std::string pending; // received bytes not yet returned
+    };
+
+  template<class Type>
+  QueryServer<Type>::QueryServer(const Graph<Type>& graph, const std::string& socketPath, int maxBatch, int threads)
+    : graph(graph), socketPath(socketPath), maxBatch(maxBatch > 0 ? maxBatch : 1), threads(threads),
+      listenSocket(-1), epollFd(-1), wakeFd(-1), stampGroup(0)
+  {
+    std::memset(&counters, 0, sizeof(counters));
+  }
+
+  template<class Type>
+  QueryServer<Type>::~QueryServer()
+  {
+    stop();
+  }
+
+  template<class Type>
+  bool QueryServer<Type>::start() throw (std::logic_error)
+  {
+    try
+    {
+      if(loop.joinable())
+        throw std::logic_error("Server is already running");
+      if(socketPath.size() >= sizeof(sockaddr_un().sun_path))
+        throw std::logic_error("Socket path is too long. Couldn't start the server");
+
+      listenSocket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      if(listenSocket == -1)
+        throw std::logic_error(std::string("Couldn't create socket: ") + std::strerror(errno));
+      sockaddr_un address;
+      std::memset(&address, 0, sizeof(address));
+      address.sun_family = AF_UNIX;
+      std::strcpy(address.sun_path, socketPath.c_str());
+      ::unlink(socketPath.c_str());
+      if(::bind(listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1 ||
+         ::listen(listenSocket, SOMAXCONN) == -1)
+        throw std::logic_error(std::string("Couldn't listen on the socket: ") + std::strerror(errno));
+
+      epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+      wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+      if(epollFd == -1 || wakeFd == -1)
+        throw std::logic_error(std::string("Couldn't create the event loop: ") + std::strerror(errno));
+      epoll_event event;
+      event.events = EPOLLIN;
+      event.data.fd = listenSocket;
+      ::epoll_ctl(epollFd, EPOLL_CTL_ADD, listenSocket, &event);
+      event.data.fd = wakeFd;
+      ::epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      if(!loop.joinable())
+        closeAll();
+      return false;
+    }
+
+    loop = std::thread(&QueryServer<Type>::run, this);
+    return true;
+  }
+
+  template<class Type>
+  void QueryServer<Type>::stop()
+  {
+    if(!loop.joinable())
+      return;
+    unsigned long long one = 1;
+    ssize_t written = ::write(wakeFd, &one, sizeof(one));
+    (void)written;
+    loop.join();
+    closeAll();
+  }
+
+  template<class Type>
+  void QueryServer<Type>::closeAll()
+  {
+    for(typename std::unordered_map<int, Connection>::iterator it = clients.begin(); it != clients.end(); ++it)
+      ::close(it->first);
+    clients.clear();
+    batch.clear();
+    if(listenSocket != -1)
+    {
+      ::close(listenSocket);
+      ::unlink(socketPath.c_str());
+    }
+    if(epollFd != -1)
+      ::close(epollFd);
+    if(wakeFd != -1)
+      ::close(wakeFd);
+    listenSocket = epollFd = wakeFd = -1;
+    std::lock_guard<std::mutex> guard(metricsLock);
+    counters.connections = 0;
+    counters.queueDepth = 0;
+  }
+
+  template<class Type>
+  std::unique_lock<std::mutex> QueryServer<Type>::pause()
+  {
+    return std::unique_lock<std::mutex>(graphLock);
+  }
+
+  template<class Type>
+  ServerMetrics QueryServer<Type>::metrics() const
+  {
+    std::lock_guard<std::mutex> guard(metricsLock);
+    return counters;
+  }
+
+  template<class Type>
+  void QueryServer<Type>::run()
+  {
+    const int MAX_EVENTS = 64;
+    epoll_event events[MAX_EVENTS];
+    bool stopping = false;
+    while(!stopping)
+    {
+      int ready = ::epoll_wait(epollFd, events, MAX_EVENTS, -1);
+      if(ready == -1)
+      {
+        if(errno == EINTR)
+          continue;
+        break;
+      }
+
+      for(int i = 0; i < ready; i++)
+      {
+        int fd = events[i].data.fd;
+        if(fd == wakeFd)
+          stopping = true;
+        else if(fd == listenSocket)
+          acceptClients();
+        else
+        {
+          if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+            readFrom(fd);
+          if((events[i].events & EPOLLOUT) && clients.count(fd))
+            flush(fd);
+        }
+      }
+
+      // everything read in this round is answered together; clients held
+      // back whose answers have drained meanwhile get their lines read
+      while(true)
+      {
+        for(typename std::unordered_map<int, Connection>::iterator it = clients.begin(); it != clients.end(); ++it)
+        {
+          if(it->second.held && it->second.output.size() < MAX_PENDING)
+            readFrom(it->first);
+        }
+        if(batch.empty())
+          break;
+        executeBatch();
+      }
+
+      std::vector<int> finished;
+      for(typename std::unordered_map<int, Connection>::iterator it = clients.begin(); it != clients.end(); ++it)
+      {
+        if(it->second.closing && it->second.output.empty())
+          finished.push_back(it->first);
+      }
+      for(size_t i = 0; i < finished.size(); i++)
+        closeClient(finished[i]);
+    }
+  }
+
+  template<class Type>
+  void QueryServer<Type>::acceptClients()
+  {
+    while(true)
+    {
+      int client = ::accept4(listenSocket, 0, 0, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if(client == -1)
+      {
+        if(errno == EINTR)
+          continue;
+        return;
+      }
+      epoll_event event;
+      event.events = EPOLLIN;
+      event.data.fd = client;
+      ::epoll_ctl(epollFd, EPOLL_CTL_ADD, client, &event);
+      Connection& connection = clients[client];
+      connection.watched = EPOLLIN;
+      connection.closing = false;
+      connection.held = false;
+      std::lock_guard<std::mutex> guard(metricsLock);
+      counters.connections++;
+    }
+  }
+
+  template<class Type>
+  void QueryServer<Type>::readFrom(int client)
+  {
+    Connection& connection = clients[client];
+    char buffer[1 << 14];
+    // read no more than a line's worth ahead, and nothing while the client
+    // isn't reading its answers
+    while(!connection.closing && connection.input.size() <= MAX_LINE && connection.output.size() < MAX_PENDING)
+    {
+      ssize_t got = ::recv(client, buffer, sizeof(buffer), 0);
+      if(got > 0)
+      {
+        connection.input.append(buffer, got);
+        continue;
+      }
+      if(got == -1 && errno == EINTR)
+        continue;
+      if(got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+        connection.closing = true;
+      break;
+    }
+
+    Clock::time_point now = Clock::now();
+    size_t begin = 0;
+    size_t end;
+    while(connection.output.size() < MAX_PENDING && (end = connection.input.find('\n', begin)) != std::string::npos)
+    {
+      // a line that arrived whole in one read can still be too long
+      if(end - begin > MAX_LINE)
+      {
+        connection.closing = true;
+        break;
+      }
+      parseLine(client, connection.input.substr(begin, end - begin), now);
+      begin = end + 1;
+      if(static_cast<int>(batch.size()) >= maxBatch)
+        executeBatch();
+    }
+    connection.input.erase(0, begin);
+    if(connection.input.size() > MAX_LINE && connection.input.find('\n') > MAX_LINE)
+      connection.closing = true;
+    connection.held = connection.output.size() >= MAX_PENDING;
+    watch(client);
+  }
+
+  template<class Type>
+  void QueryServer<Type>::parseLine(int client, const std::string& line, Clock::time_point now)
+  {
+    std::istringstream words(line);
+    std::string command;
+    Request request;
+    request.client = client;
+    request.kind = MALFORMED;
+    request.fromIndex = request.toIndex = -1;
+    request.answer = -1;
+    request.error = 0;
+    request.received = now;
+
+    words >> command;
+    if(command == "STATS")
+      request.kind = STATS;
+    else if(command == "ADJ" || command == "WEIGHT" || command == "BFS")
+    {
+      request.kind = command == "ADJ" ? ADJACENT : (command == "WEIGHT" ? WEIGHT : DISTANCE);
+      if(!(words >> request.fromWord >> request.toWord))
+      {
+        request.kind = MALFORMED;
+        request.error = "ERR expected two vertices";
+      }
+    }
+    else if(command.empty())
+      return;
+    else
+      request.error = "ERR unknown command";
+    batch.push_back(request);
+
+    std::lock_guard<std::mutex> guard(metricsLock);
+    counters.queueDepth++;
+    counters.maxQueueDepth = std::max(counters.maxQueueDepth, counters.queueDepth);
+  }
+
+  template<class Type>
+  void QueryServer<Type>::executeBatch()
+  {
+    std::vector<int> edgeQueries;
+    std::vector<int> distanceQueries;
+    {
+      std::lock_guard<std::mutex> guard(graphLock);
+      for(size_t i = 0; i < batch.size(); i++)
+      {
+        Request& request = batch[i];
+        if(request.kind != ADJACENT && request.kind != WEIGHT && request.kind != DISTANCE)
+          continue;
+        Type from, to;
+        if(parseInfo(request.fromWord, from) && parseInfo(request.toWord, to))
+        {
+          request.fromIndex = graph.positionOf(graph.handleOf(from));
+          request.toIndex = graph.positionOf(graph.handleOf(to));
+        }
+        if(request.fromIndex == -1 || request.toIndex == -1)
+          request.error = "ERR no such vertex";
+        else if(request.kind == DISTANCE)
+          distanceQueries.push_back(static_cast<int>(i));
+        else
+          edgeQueries.push_back(static_cast<int>(i));
+      }
+      answerEdges(edgeQueries);
+      answerDistances(distanceQueries);
+    }
+
+    Clock::time_point answered = Clock::now();
+    std::vector<int> touched;
+    std::ostringstream line;
+    for(size_t i = 0; i < batch.size(); i++)
+    {
+      const Request& request = batch[i];
+      Connection& connection = clients[request.client];
+      if(request.error != 0)
+        connection.output += request.error;
+      else if(request.kind == STATS)
+        connection.output += formatMetrics();
+      else
+      {
+        line.str(std::string());
+        line << request.answer;
+        connection.output += line.str();
+      }
+      connection.output += '\n';
+      if(touched.empty() || touched.back() != request.client)
+        touched.push_back(request.client);
+    }
+
+    {
+      std::lock_guard<std::mutex> guard(metricsLock);
+      for(size_t i = 0; i < batch.size(); i++)
+      {
+        long long micros = std::chrono::duration_cast<std::chrono::microseconds>(answered - batch[i].received).count();
+        int bucket = 0;
+        while(bucket < ServerMetrics::LATENCY_BUCKETS - 1 && (1LL << bucket) <= micros)
+          bucket++;
+        counters.latencyHistogram[bucket]++;
+        counters.totalLatencyMicros += micros;
+        counters.maxLatencyMicros = std::max(counters.maxLatencyMicros, micros);
+      }
+      counters.requests += batch.size();
+      counters.batches++;
+      counters.largestBatch = std::max(counters.largestBatch, static_cast<long long>(batch.size()));
+      counters.queueDepth -= batch.size();
+    }
+    batch.clear();
+
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    for(size_t i = 0; i < touched.size(); i++)
+      flush(touched[i]);
+  }
+
+  template<class Type>
+  void QueryServer<Type>::answerEdges(const std::vector<int>& indices)
+  {
+    std::vector<int> order(indices);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b)
+    {
+      return batch[a].fromIndex < batch[b].fromIndex;
+    });
+    stamp.resize(graph.vertexCount(), -1);
+    stampWeight.resize(graph.vertexCount());
+
+    for(size_t first = 0; first < order.size(); )
+    {
+      // scan the adjacency list of this source once for the whole group
+      int source = batch[order[first]].fromIndex;
+      long long group = stampGroup++;
+      graph.forEachNeighbor(source, [&](int connIndex, int edgeWeight)
+      {
+        if(stamp[connIndex] != group)
+        {
+          stamp[connIndex] = group;
+          stampWeight[connIndex] = edgeWeight;
+        }
+      });
+      size_t last = first;
+      for( ; last < order.size() && batch[order[last]].fromIndex == source; last++)
+      {
+        Request& request = batch[order[last]];
+        bool adjacent = stamp[request.toIndex] == group;
+        if(request.kind == ADJACENT)
+          request.answer = adjacent ? 1 : 0;
+        else
+          request.answer = adjacent ? stampWeight[request.toIndex] : -1;
+      }
+      first = last;
+    }
+  }
+
+  template<class Type>
+  void QueryServer<Type>::answerDistances(const std::vector<int>& indices)
+  {
+    if(indices.empty())
+      return;
+    std::vector<int> order(indices);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b)
+    {
+      return batch[a].fromIndex < batch[b].fromIndex;
+    });
+    std::vector<size_t> groupStart;
+    for(size_t i = 0; i < order.size(); i++)
+    {
+      if(i == 0 || batch[order[i]].fromIndex != batch[order[i - 1]].fromIndex)
+        groupStart.push_back(i);
+    }
+    groupStart.push_back(order.size());
+
+    int vertices = graph.vertexCount();
+    long long groups = static_cast<long long>(groupStart.size()) - 1;
+    int searchThreads = resolveThreadCount(threads, groups * (vertices + graph.edgeCount()), 1 << 14);
+    parallelFor(0, groups, searchThreads, [&](long long firstGroup, long long lastGroup, int)
+    {
+      std::vector<int> distance(vertices, -1);
+      std::vector<char> wanted(vertices, 0);
+      std::vector<int> queue;
+      for(long long g = firstGroup; g < lastGroup; g++)
+      {
+        // one search per source, stopping once every target of the group is reached
+        int source = batch[order[groupStart[g]]].fromIndex;
+        size_t targets = 0;
+        size_t reached = 0;
+        for(size_t i = groupStart[g]; i < groupStart[g + 1]; i++)
+        {
+          char& want = wanted[batch[order[i]].toIndex];
+          targets += want == 0;
+          want = 1;
+        }
+
+        queue.assign(1, source);
+        distance[source] = 0;
+        for(size_t head = 0; head < queue.size(); head++)
+        {
+          int u = queue[head];
+          if(wanted[u])
+          {
+            wanted[u] = 0;
+            reached++;
+          }
+          if(reached == targets)
+            break;
+          graph.forEachNeighbor(u, [&](int connIndex, int)
+          {
+            if(distance[connIndex] == -1)
+            {
+              distance[connIndex] = distance[u] + 1;
+              queue.push_back(connIndex);
+            }
+          });
+        }
+
+        for(size_t i = groupStart[g]; i < groupStart[g + 1]; i++)
+        {
+          batch[order[i]].answer = distance[batch[order[i]].toIndex];
+          wanted[batch[order[i]].toIndex] = 0;
+        }
+        for(size_t i = 0; i < queue.size(); i++)
+          distance[queue[i]] = -1;
+      }
+    });
+  }
+
+  template<class Type>
+  void QueryServer<Type>::flush(int client)
+  {
+    Connection& connection = clients[client];
+    size_t sent = 0;
+    while(sent < connection.output.size())
+    {
+      ssize_t written = ::send(client, connection.output.data() + sent, connection.output.size() - sent, MSG_NOSIGNAL);
+      if(written > 0)
+      {
+        sent += written;
+        continue;
+      }
+      if(written == -1 && errno == EINTR)
+        continue;
+      if(written == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+      {
+        // the client is gone, drop what it will never read
+        connection.closing = true;
+        sent = connection.output.size();
+      }
+      break;
+    }
+    connection.output.erase(0, sent);
+    watch(client);
+  }
+
+  template<class Type>
+  void QueryServer<Type>::watch(int client)
+  {
+    // read until the client hangs up or falls MAX_PENDING behind, write
+    // while answers are pending
+    Connection& connection = clients[client];
+    bool reading = !connection.closing && connection.output.size() < MAX_PENDING;
+    unsigned wanted = (reading ? static_cast<unsigned>(EPOLLIN) : 0u) | (connection.output.empty() ? 0u : static_cast<unsigned>(EPOLLOUT));
+    if(wanted != connection.watched)
+    {
+      epoll_event event;
+      event.events = wanted;
+      event.data.fd = client;
+      ::epoll_ctl(epollFd, EPOLL_CTL_MOD, client, &event);
+      connection.watched = wanted;
+    }
+  }
+
+  template<class Type>
+  void QueryServer<Type>::closeClient(int client)
+  {
+    ::epoll_ctl(epollFd, EPOLL_CTL_DEL, client, 0);
+    ::close(client);
+    clients.erase(client);
+    std::lock_guard<std::mutex> guard(metricsLock);
+    counters.connections--;
+  }
+
+  template<class Type>
+  std::string QueryServer<Type>::formatMetrics() const
+  {
+    ServerMetrics current = metrics();
+    std::ostringstream text;
+    text << "requests=" << current.requests << " batches=" << current.batches
+         << " largestBatch=" << current.largestBatch << " queueDepth=" << current.queueDepth
+         << " maxQueueDepth=" << current.maxQueueDepth << " connections=" << current.connections
+         << " meanLatencyUs=" << current.meanLatencyMicros() << " p99LatencyUs=" << current.latencyPercentileMicros(0.99)
+         << " maxLatencyUs=" << current.maxLatencyMicros;
+    return text.str();
+  }
+}
+#endif
@@ -0,0 +1,314 @@
+#include "graph.h"
+#include <cmath>
+
+/**
+ * File: graph_sketch.h
+ * Description: This file contains approximate structural sketches of a
+ *              graph: ReachabilitySketch, HyperLogLog counters estimating
+ *              how many vertices lie within k hops of each vertex (as in
+ *              HyperANF), and SimilaritySketch, MinHash signatures of the
+ *              adjacency lists estimating their Jaccard similarity. Both are
+ *              built in parallel and answer queries in constant time.
+ */
+
+#ifndef _GRAPH_SKETCH_H_
+#define _GRAPH_SKETCH_H_
+
+namespace GraphNameSpace
+{
+  /**
+  * Description: One HyperLogLog counter per vertex. After hop h the counter
+  * of v holds every vertex reachable from v over at most h edges; it is the
+  * union (register-wise maximum) of its own counter and those of its
+  * neighbours after hop h - 1. The estimate of every vertex at every hop is
+  * kept, so queries don't touch the counters.
+  *
+  * With m registers per counter the relative standard error is about
+  * 1.04 / sqrt(m); the counters take 2 * m bytes per vertex while building.
+  */
+    class ReachabilitySketch
+    {
+    public:
+
+    /**
+      * Function: ReachabilitySketch - The overloaded constructor with a graph
+      * Description: builds the counters hop by hop
+      * Function input: the graph, the most hops to answer for, the wanted
+      *                 relative standard error, the number of threads (0 for
+      *                 all cores) and a seed for the hash
+      * Function output: None.
+      * Precondition: maxHops >= 0, 0 < relativeError < 1
+      * Postcondition: the sketch answers for 0 to maxHops hops; the error
+      *                is rounded down to what 16 to 65536 registers give
+      */
+      template<class GraphType>
+      ReachabilitySketch(const GraphType& graph, int maxHops, double relativeError = 0.05,
+                         int threads = 0, unsigned long long seed = 0);
+
+    /**
+      * Function: reachableWithin
+      * Description: estimates the number of vertices within a number of
+      *              hops of a vertex, the vertex itself included
+      * Function input: the position of the vertex and the hops
+      * Function output: the estimate, 0 for an empty position
+      * Precondition: 0 <= hops; more than maxHops answers for maxHops
+      * Postcondition: none
+      */
+      double reachableWithin(int vertexIndex, int hops) const;
+
+    /**
+      * Function: pairsWithin
+      * Description: estimates the number of pairs (u, v) with v within a
+      *              number of hops of u (the neighbourhood function)
+      */
+      double pairsWithin(int hops) const;
+
+    /**
+      * Function: registerCount / relativeError / maxHops / hopsToConverge
+      * Description: the registers per counter, the error they give, the
+      *              hops answered for, and the hops after which no counter
+      *              changed any more (maxHops if they still changed)
+      */
+      int registerCount() const { return registers; }
+      double relativeError() const { return 1.04 / std::sqrt(static_cast<double>(registers)); }
+      int maxHops() const { return hopLimit; }
+      int hopsToConverge() const { return converged; }
+
+    private:
+      /**
+      * Function: estimate
+      * Description: the HyperLogLog estimate of one counter, with the small
+      *              range correction
+      */
+      double estimate(const unsigned char* counter) const;
+
+      int vertices; // number of positions
+      int registers; // registers per counter, a power of two
+      int hopLimit; // most hops answered for
+      int converged; // hops after which nothing changed
+      std::vector<float> estimates; // estimates[hop * vertices + v]
+      std::vector<double> pairs; // sum of the estimates per hop
+      double inversePower[64]; // 2^-k, the weight of a register holding k
+    };
+
+  /**
+  * Description: A MinHash signature of the adjacency list of every vertex.
+  * The fraction of matching entries in two signatures estimates the Jaccard
+  * similarity of the two neighbour sets with standard error at most
+  * 1 / (2 sqrt(k)) for k entries.
+  */
+    class SimilaritySketch
+    {
+    public:
+
+    /**
+      * Function: SimilaritySketch - The overloaded constructor with a graph
+      * Description: computes the signatures
+      * Function input: the graph, the wanted standard error, the number of
+      *                 threads (0 for all cores) and a seed for the hashes
+      * Function output: None.
+      * Precondition: 0 < error < 1
+      * Postcondition: the signatures are 4 * k bytes per vertex
+      */
+      template<class GraphType>
+      SimilaritySketch(const GraphType& graph, double error = 0.05, int threads = 0, unsigned long long seed = 0);
+
+    /**
+      * Function: jaccard
+      * Description: estimates |N(a) & N(b)| / |N(a) | N(b)| for the
+      *              neighbours of two vertices
+      * Function input: two vertex positions
+      * Function output: the estimate; 0 if either vertex has no neighbours
+      *                  (exact when only one has none, and taken as 0 when
+      *                  both have none) or a position is out of range
+      */
+      double jaccard(int fromIndex, int toIndex) const;
+
+    /**
+      * Function: signatureSize
+      * Description: the entries per signature
+      */
+      int signatureSize() const { return hashes; }
+
+    private:
+      int hashes; // entries per signature
+      std::vector<unsigned> signature; // signature[v * hashes + i]
+      std::vector<char> empty; // 1 if the vertex has no neighbours
+    };
+
+  template<class GraphType>
+  ReachabilitySketch::ReachabilitySketch(const GraphType& graph, int maxHops, double relativeError,
+                                         int threads, unsigned long long seed)
+    : vertices(graph.positionCount()), registers(16), hopLimit(maxHops < 0 ? 0 : maxHops), converged(0)
+  {
+    double wanted = relativeError > 0 ? 1.04 / relativeError : 1.0;
+    while(registers < (1 << 16) && registers < wanted * wanted)
+      registers *= 2;
+    int bits = 0;
+    while((1 << bits) < registers)
+      bits++;
+    for(int k = 0; k < 64; k++)
+      inversePower[k] = std::ldexp(1.0, -k);
+
+    std::vector<unsigned char> current(static_cast<size_t>(vertices) * registers, 0);
+    std::vector<unsigned char> next(current.size());
+    estimates.resize(static_cast<size_t>(hopLimit + 1) * vertices);
+    pairs.assign(hopLimit + 1, 0);
+
+    threads = resolveThreadCount(threads, static_cast<long long>(vertices) * registers, 1 << 16);
+    std::vector<double> chunkPairs(threads);
+    std::vector<char> chunkChanged(threads);
+
+    // hop 0: every counter holds its own vertex. The seed is hashed before it
+    // meets the position, or small seeds would only permute small positions
+    unsigned long long salt = mixHash64(seed);
+    parallelFor(0, vertices, threads, [&](long long first, long long last, int chunk)
+    {
+      double sum = 0;
+      for(long long v = first; v < last; v++)
+      {
+        if(graph.containsVertex(static_cast<int>(v)))
+        {
+          unsigned long long hash = mixHash64(static_cast<unsigned long long>(v) ^ salt);
+          unsigned long long rest = (hash << bits) | (1ULL << (bits - 1));
+          current[v * registers + (hash >> (64 - bits))] = static_cast<unsigned char>(__builtin_clzll(rest) + 1);
+        }
+        estimates[v] = static_cast<float>(estimate(&current[v * registers]));
+        sum += estimates[v];
+      }
+      chunkPairs[chunk] = sum;
+    });
+    for(int t = 0; t < threads; t++)
+      pairs[0] += chunkPairs[t];
+
+    for(int hop = 1; hop <= hopLimit; hop++)
+    {
+      float* hopEstimates = &estimates[static_cast<size_t>(hop) * vertices];
+      if(converged < hop - 1)
+      {
+        // nothing changed last hop, nothing will
+        std::copy(hopEstimates - vertices, hopEstimates, hopEstimates);
+        pairs[hop] = pairs[hop - 1];
+        continue;
+      }
+
+      std::fill(chunkPairs.begin(), chunkPairs.end(), 0.0);
+      std::fill(chunkChanged.begin(), chunkChanged.end(), 0);
+      parallelFor(0, vertices, threads, [&](long long first, long long last, int chunk)
+      {
+        double sum = 0;
+        bool changed = false;
+        for(long long v = first; v < last; v++)
+        {
+          unsigned char* target = &next[v * registers];
+          const unsigned char* own = &current[v * registers];
+          std::copy(own, own + registers, target);
+          graph.forEachNeighbor(static_cast<int>(v), [&](int connIndex, int)
+          {
+            const unsigned char* other = &current[static_cast<size_t>(connIndex) * registers];
+            for(int r = 0; r < registers; r++)
+              target[r] = std::max(target[r], other[r]);
+          });
+          if(!changed && !std::equal(own, own + registers, target))
+            changed = true;
+          hopEstimates[v] = static_cast<float>(estimate(target));
+          sum += hopEstimates[v];
+        }
+        chunkPairs[chunk] = sum;
+        chunkChanged[chunk] = changed;
+      });
+
+      current.swap(next);
+      for(int t = 0; t < threads; t++)
+      {
+        pairs[hop] += chunkPairs[t];
+        if(chunkChanged[t])
+          converged = hop;
+      }
+    }
+  }
+
+  inline double ReachabilitySketch::estimate(const unsigned char* counter) const
+  {
+    double sum = 0;
+    int zeros = 0;
+    for(int r = 0; r < registers; r++)
+    {
+      sum += inversePower[counter[r]];
+      zeros += counter[r] == 0;
+    }
+    if(zeros == registers)
+      return 0;
+    double m = registers;
+    double alpha = registers == 16 ? 0.673 : (registers == 32 ? 0.697 : (registers == 64 ? 0.709 : 0.7213 / (1 + 1.079 / m)));
+    double raw = alpha * m * m / sum;
+    if(raw <= 2.5 * m && zeros > 0)
+      return m * std::log(m / zeros);
+    return raw;
+  }
+
+  inline double ReachabilitySketch::reachableWithin(int vertexIndex, int hops) const
+  {
+    if(vertexIndex < 0 || vertexIndex >= vertices || hops < 0)
+      return 0;
+    return estimates[static_cast<size_t>(std::min(hops, hopLimit)) * vertices + vertexIndex];
+  }
+
+  inline double ReachabilitySketch::pairsWithin(int hops) const
+  {
+    return hops < 0 ? 0 : pairs[std::min(hops, hopLimit)];
+  }
+
+  template<class GraphType>
+  SimilaritySketch::SimilaritySketch(const GraphType& graph, double error, int threads, unsigned long long seed)
+    : hashes(1)
+  {
+    double wanted = error > 0 ? 0.25 / (error * error) : 1.0;
+    hashes = static_cast<int>(std::ceil(wanted));
+    if(hashes < 1)
+      hashes = 1;
+
+    int vertices = graph.positionCount();
+    signature.assign(static_cast<size_t>(vertices) * hashes, ~0u);
+    empty.assign(vertices, 1);
+    std::vector<unsigned long long> salt(hashes);
+    for(int i = 0; i < hashes; i++)
+      salt[i] = mixHash64(seed + static_cast<unsigned long long>(i) * 0x632be59bd9b4e019ULL);
+
+    threads = resolveThreadCount(threads, static_cast<long long>(graph.edgeCount()) * hashes, 1 << 16);
+    parallelFor(0, vertices, threads, [&](long long first, long long last, int)
+    {
+      for(long long v = first; v < last; v++)
+      {
+        unsigned* entry = &signature[v * hashes];
+        graph.forEachNeighbor(static_cast<int>(v), [&](int connIndex, int)
+        {
+          empty[v] = 0;
+          unsigned long long base = mixHash64(static_cast<unsigned long long>(connIndex));
+          for(int i = 0; i < hashes; i++)
+          {
+            // one hash function per entry, derived from the neighbour's hash
+            unsigned value = static_cast<unsigned>(mixHash64(base ^ salt[i]) >> 32);
+            entry[i] = std::min(entry[i], value);
+          }
+        });
+      }
+    });
+  }
+
+  inline double SimilaritySketch::jaccard(int fromIndex, int toIndex) const
+  {
+    int vertices = static_cast<int>(empty.size());
+    if(fromIndex < 0 || toIndex < 0 || fromIndex >= vertices || toIndex >= vertices)
+      return 0;
+    if(empty[fromIndex] || empty[toIndex])
+      return 0;
+    const unsigned* a = &signature[static_cast<size_t>(fromIndex) * hashes];
+    const unsigned* b = &signature[static_cast<size_t>(toIndex) * hashes];
+    int matches = 0;
+    for(int i = 0; i < hashes; i++)
+      matches += a[i] == b[i];
+    return static_cast<double>(matches) / hashes;
+  }
+}
+#endif
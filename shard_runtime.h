@@ -0,0 +1,538 @@
+#include "graph_partition.h"
+#include "graph_export.h"
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * File: shard_runtime.h
+ * Description: This file contains the shard runtime: the ShardTransport
+ *              interface shards use to exchange messages, an in-process
+ *              LocalTransport, breadth first search and PageRank that run
+ *              on every shard at once in bulk synchronous steps, and
+ *              writeShard / readShard to ship a shard to another process.
+ *              Only LocalTransport is provided; running shards in separate
+ *              processes needs a ShardTransport over sockets or MPI.
+ */
+
+#ifndef _SHARD_RUNTIME_H_
+#define _SHARD_RUNTIME_H_
+
+namespace GraphNameSpace
+{
+  /**
+  * Description: A message about a vertex, addressed to the shard that owns it
+  */
+    struct ShardMessage
+    {
+      int vertex; // position of the vertex in the whole graph
+      double value; // what is being said about it
+    };
+
+  /**
+  * Description: How shards talk to each other. Every shard calls exchange
+  * and sumAcrossShards the same number of times, in the same order; each
+  * call is a step boundary that waits for all shards. A transport between
+  * processes (sockets, MPI, ...) implements this interface; LocalTransport
+  * connects shards running as threads of one process.
+  */
+    class ShardTransport
+    {
+    public:
+      virtual ~ShardTransport() {}
+
+      /**
+      * Function: shardCount
+      * Description: returns the number of shards connected by the transport
+      */
+      virtual int shardCount() const = 0;
+
+      /**
+      * Function: send
+      * Description: queues messages from one shard to another, they are
+      *              delivered by the next exchange
+      */
+      virtual void send(int fromShard, int toShard, const std::vector<ShardMessage>& messages) = 0;
+
+      /**
+      * Function: exchange
+      * Description: waits until every shard has sent its messages for this
+      *              step and hands a shard the messages addressed to it,
+      *              ordered by sending shard
+      */
+      virtual void exchange(int shard, std::vector<ShardMessage>& received) = 0;
+
+      /**
+      * Function: sumAcrossShards
+      * Description: waits for every shard and returns the sum of the values
+      *              they passed
+      */
+      virtual double sumAcrossShards(int shard, double value) = 0;
+    };
+
+  /**
+  * Description: A transport for shards running as threads of one process,
+  * the mailboxes live in shared memory
+  */
+    class LocalTransport : public ShardTransport
+    {
+    public:
+      explicit LocalTransport(int shards)
+        : shards(shards), mailbox(shards, std::vector<std::vector<ShardMessage> >(shards)),
+          mailboxLock(shards), waiting(0), generation(0), contribution(shards, 0)
+      {
+      }
+
+      int shardCount() const
+      {
+        return shards;
+      }
+
+      void send(int fromShard, int toShard, const std::vector<ShardMessage>& messages)
+      {
+        std::lock_guard<std::mutex> guard(mailboxLock[toShard]);
+        std::vector<ShardMessage>& box = mailbox[toShard][fromShard];
+        box.insert(box.end(), messages.begin(), messages.end());
+      }
+
+      void exchange(int shard, std::vector<ShardMessage>& received)
+      {
+        barrier();
+        received.clear();
+        for(int from = 0; from < shards; from++)
+        {
+          std::vector<ShardMessage>& box = mailbox[shard][from];
+          received.insert(received.end(), box.begin(), box.end());
+          box.clear();
+        }
+        // nobody may send the next step's messages before every mailbox is emptied
+        barrier();
+      }
+
+      double sumAcrossShards(int shard, double value)
+      {
+        contribution[shard] = value;
+        barrier();
+        double sum = 0;
+        for(int s = 0; s < shards; s++)
+          sum += contribution[s];
+        barrier();
+        return sum;
+      }
+
+    private:
+      void barrier()
+      {
+        std::unique_lock<std::mutex> guard(barrierLock);
+        long arrivedIn = generation;
+        if(++waiting == shards)
+        {
+          waiting = 0;
+          generation++;
+          barrierDone.notify_all();
+        }
+        else
+        {
+          barrierDone.wait(guard, [&]() { return generation != arrivedIn; });
+        }
+      }
+
+      int shards; // number of shards
+      std::vector<std::vector<std::vector<ShardMessage> > > mailbox; // mailbox[to][from]
+      std::vector<std::mutex> mailboxLock; // one per receiving shard
+      std::mutex barrierLock;
+      std::condition_variable barrierDone;
+      int waiting; // shards waiting at the barrier
+      long generation; // number of barriers passed
+      std::vector<double> contribution; // values passed to sumAcrossShards
+    };
+
+  /**
+  * Function: writeShard
+  * Description: writes a shard in a portable binary form: the magic
+  *              "GRAPHSHD", then little endian 32 bit integers (shard id,
+  *              shard count, owned count, flags, local count, edge count,
+  *              the global index of every local vertex, the owner of every
+  *              ghost, the offsets, targets and weights), then the info of
+  *              every owned vertex as a length and the formatInfo text
+  * Function input: the shard and the stream
+  * Function output: none
+  */
+  template<class Type>
+  void writeShard(const GraphShard<Type>& shard, std::ostream& out)
+  {
+    OutputBuffer buffer;
+    buffer.append("GRAPHSHD", 8);
+    buffer.appendInt32(shard.shardId);
+    buffer.appendInt32(shard.shardCount);
+    buffer.appendInt32(shard.ownedCount);
+    buffer.appendInt32((shard.direction == DIRECTED ? 1 : 0) | (shard.weigh == WEIGHTED ? 2 : 0));
+    buffer.appendInt32(static_cast<int>(shard.globalIndex.size()));
+    buffer.appendInt32(static_cast<int>(shard.target.size()));
+    for(size_t i = 0; i < shard.globalIndex.size(); i++)
+      buffer.appendInt32(shard.globalIndex[i]);
+    for(size_t i = 0; i < shard.ghostOwner.size(); i++)
+      buffer.appendInt32(shard.ghostOwner[i]);
+    for(size_t i = 0; i < shard.offset.size(); i++)
+      buffer.appendInt32(shard.offset[i]);
+    for(size_t i = 0; i < shard.target.size(); i++)
+    {
+      buffer.appendInt32(shard.target[i]);
+      buffer.appendInt32(shard.weight[i]);
+    }
+    std::string text;
+    for(size_t i = 0; i < shard.info.size(); i++)
+    {
+      formatInfo(shard.info[i], text);
+      buffer.appendInt32(static_cast<int>(text.size()));
+      buffer.append(text);
+    }
+    out.write(buffer.data(), buffer.size());
+    out.flush();
+  }
+
+  /**
+  * Function: readInt32
+  * Description: reads a little endian 32 bit integer written by OutputBuffer
+  */
+  inline bool readInt32(std::istream& in, int& value)
+  {
+    unsigned char bytes[4];
+    if(!in.read(reinterpret_cast<char*>(bytes), 4))
+      return false;
+    value = static_cast<int>(bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<unsigned int>(bytes[3]) << 24));
+    return true;
+  }
+
+  /**
+  * Function: readShard
+  * Description: reads a shard written by writeShard. Damaged input is
+  *              rejected: the ids, counts, offsets and every index must be
+  *              in range and the global indices distinct.
+  * Function input: the stream and the shard to fill
+  * Function output: true if a whole shard was read
+  * Precondition: none
+  * Postcondition: errors are printed and leave the shard empty
+  */
+  template<class Type>
+  bool readShard(std::istream& in, GraphShard<Type>& shard) throw (std::logic_error)
+  {
+    shard = GraphShard<Type>();
+    try
+    {
+      char magic[8];
+      if(!in.read(magic, 8) || std::string(magic, 8) != "GRAPHSHD")
+        throw std::logic_error("Not a shard. Couldn't read it");
+      int flags, locals, edges;
+      if(!readInt32(in, shard.shardId) || !readInt32(in, shard.shardCount) || !readInt32(in, shard.ownedCount) ||
+         !readInt32(in, flags) || !readInt32(in, locals) || !readInt32(in, edges) ||
+         shard.shardCount <= 0 || shard.shardId < 0 || shard.shardId >= shard.shardCount ||
+         shard.ownedCount < 0 || locals < shard.ownedCount || edges < 0)
+        throw std::logic_error("Shard header is damaged. Couldn't read it");
+      shard.direction = (flags & 1) ? DIRECTED : UNDIRECTED;
+      shard.weigh = (flags & 2) ? WEIGHTED : UNWEIGHTED;
+
+      // the arrays grow as values arrive, so a damaged count can't make
+      // them allocate more than the stream holds; every index is checked
+      // before the runtime uses it to address an array
+      bool complete = true;
+      int value;
+      for(int i = 0; i < locals && complete; i++)
+      {
+        complete = readInt32(in, value) && value >= 0 && shard.localIndex.insert(std::make_pair(value, i)).second;
+        shard.globalIndex.push_back(value);
+      }
+      for(int i = shard.ownedCount; i < locals && complete; i++)
+      {
+        complete = readInt32(in, value) && value >= 0 && value < shard.shardCount && value != shard.shardId;
+        shard.ghostOwner.push_back(value);
+      }
+      for(int i = 0; i <= shard.ownedCount && complete; i++)
+      {
+        complete = readInt32(in, value) && value >= (i == 0 ? 0 : shard.offset.back()) && value <= edges;
+        shard.offset.push_back(value);
+      }
+      complete = complete && shard.offset.front() == 0 && shard.offset.back() == edges;
+      for(int i = 0; i < edges && complete; i++)
+      {
+        int edgeWeight;
+        complete = readInt32(in, value) && readInt32(in, edgeWeight) && value >= 0 && value < locals;
+        shard.target.push_back(value);
+        shard.weight.push_back(edgeWeight);
+      }
+      std::string text;
+      for(int i = 0; i < shard.ownedCount && complete; i++)
+      {
+        int length = 0;
+        complete = readInt32(in, length) && length >= 0;
+        shard.info.push_back(Type());
+        // read in pieces, a damaged length mustn't allocate ahead of the bytes
+        const int PIECE = 4096;
+        char piece[PIECE];
+        text.clear();
+        for(int left = length; left > 0 && complete; left -= PIECE)
+        {
+          std::streamsize size = std::min(left, PIECE);
+          complete = static_cast<bool>(in.read(piece, size));
+          text.append(piece, size);
+        }
+        complete = complete && parseInfo(text, shard.info.back());
+      }
+      if(!complete)
+        throw std::logic_error("Shard is truncated or damaged. Couldn't read it");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      shard = GraphShard<Type>();
+      return false;
+    }
+    return true;
+  }
+
+  /**
+  * Function: ownedLocal
+  * Description: the local index of a vertex a message is addressed to
+  * Function output: the index, -1 if the shard doesn't own the vertex
+  */
+  template<class Type>
+  inline int ownedLocal(const GraphShard<Type>& shard, int vertex)
+  {
+    std::unordered_map<int, int>::const_iterator found = shard.localIndex.find(vertex);
+    return found == shard.localIndex.end() || found->second >= shard.ownedCount ? -1 : found->second;
+  }
+
+  /**
+  * Function: reportStrayMessages
+  * Description: prints how many messages of a step were dropped because
+  *              they named a vertex the shard doesn't own
+  */
+  inline void reportStrayMessages(int shardId, int stray) throw (std::logic_error)
+  {
+    try
+    {
+      if(stray > 0)
+        throw std::logic_error("Shard got messages for vertices it doesn't own. They were dropped");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: shard " << shardId << ": " << stray << ' ' << bad_item.what() << '\n';
+    }
+  }
+
+  /**
+  * Function: sendToOwners
+  * Description: sends every non-empty outgoing batch and clears it
+  */
+  inline void sendToOwners(ShardTransport& transport, int fromShard, std::vector<std::vector<ShardMessage> >& outgoing)
+  {
+    for(size_t s = 0; s < outgoing.size(); s++)
+    {
+      if(!outgoing[s].empty())
+        transport.send(fromShard, static_cast<int>(s), outgoing[s]);
+      outgoing[s].clear();
+    }
+  }
+
+  /**
+  * Function: shardBreadthFirst
+  * Description: breadth first search run by every shard together, one
+  *              level per step. A vertex reached through a ghost is sent to
+  *              its owner, at most once per ghost.
+  * Function input: this shard, the transport and the position of the start
+  *                 vertex in the whole graph
+  * Function output: the number of edges from the start to each owned
+  *                  vertex, -1 if unreachable
+  */
+  template<class Type>
+  std::vector<int> shardBreadthFirst(const GraphShard<Type>& shard, ShardTransport& transport, int sourceIndex)
+  {
+    std::vector<int> distance(shard.ownedCount, -1);
+    std::vector<char> ghostSent(shard.ghostOwner.size(), 0);
+    std::vector<std::vector<ShardMessage> > outgoing(shard.shardCount);
+    std::vector<ShardMessage> received;
+    std::vector<int> frontier;
+    std::vector<int> next;
+
+    std::unordered_map<int, int>::const_iterator source = shard.localIndex.find(sourceIndex);
+    if(source != shard.localIndex.end() && source->second < shard.ownedCount)
+    {
+      distance[source->second] = 0;
+      frontier.push_back(source->second);
+    }
+
+    for(int level = 0; ; level++)
+    {
+      next.clear();
+      for(size_t i = 0; i < frontier.size(); i++)
+      {
+        int u = frontier[i];
+        for(int e = shard.offset[u]; e < shard.offset[u + 1]; e++)
+        {
+          int t = shard.target[e];
+          if(t < shard.ownedCount)
+          {
+            if(distance[t] == -1)
+            {
+              distance[t] = level + 1;
+              next.push_back(t);
+            }
+          }
+          else if(!ghostSent[t - shard.ownedCount])
+          {
+            ghostSent[t - shard.ownedCount] = 1;
+            ShardMessage message = {shard.globalIndex[t], static_cast<double>(level + 1)};
+            outgoing[shard.ghostOwner[t - shard.ownedCount]].push_back(message);
+          }
+        }
+      }
+
+      sendToOwners(transport, shard.shardId, outgoing);
+      transport.exchange(shard.shardId, received);
+      int stray = 0;
+      for(size_t i = 0; i < received.size(); i++)
+      {
+        int local = ownedLocal(shard, received[i].vertex);
+        if(local == -1)
+          stray++;
+        else if(distance[local] == -1)
+        {
+          distance[local] = static_cast<int>(received[i].value);
+          next.push_back(local);
+        }
+      }
+      reportStrayMessages(shard.shardId, stray);
+
+      if(transport.sumAcrossShards(shard.shardId, static_cast<double>(next.size())) == 0)
+        break;
+      frontier.swap(next);
+    }
+    return distance;
+  }
+
+  /**
+  * Function: shardPageRank
+  * Description: PageRank run by every shard together. Each step a shard
+  *              pushes rank along the edges of its owned vertices, adds up
+  *              what goes to each ghost and sends one message per ghost to
+  *              its owner. Rank of vertices without edges is spread evenly.
+  * Function input: this shard, the transport, the maximum number of
+  *                 iterations, the damping factor and the total change in
+  *                 rank below which to stop early (0 never stops early)
+  * Function output: the rank of each owned vertex
+  */
+  template<class Type>
+  std::vector<double> shardPageRank(const GraphShard<Type>& shard, ShardTransport& transport, int iterations,
+                                    double damping = 0.85, double tolerance = 0)
+  {
+    double vertices = transport.sumAcrossShards(shard.shardId, shard.ownedCount);
+    std::vector<double> rank(shard.ownedCount, vertices > 0 ? 1.0 / vertices : 0);
+    std::vector<double> incoming(shard.ownedCount);
+    std::vector<double> ghostShare(shard.ghostOwner.size());
+    std::vector<std::vector<ShardMessage> > outgoing(shard.shardCount);
+    std::vector<ShardMessage> received;
+
+    for(int iteration = 0; iteration < iterations; iteration++)
+    {
+      std::fill(incoming.begin(), incoming.end(), 0.0);
+      std::fill(ghostShare.begin(), ghostShare.end(), 0.0);
+      double dangling = 0;
+      for(int u = 0; u < shard.ownedCount; u++)
+      {
+        int degree = shard.offset[u + 1] - shard.offset[u];
+        if(degree == 0)
+        {
+          dangling += rank[u];
+          continue;
+        }
+        double share = rank[u] / degree;
+        for(int e = shard.offset[u]; e < shard.offset[u + 1]; e++)
+        {
+          int t = shard.target[e];
+          if(t < shard.ownedCount)
+            incoming[t] += share;
+          else
+            ghostShare[t - shard.ownedCount] += share;
+        }
+      }
+
+      for(size_t g = 0; g < ghostShare.size(); g++)
+      {
+        if(ghostShare[g] != 0)
+        {
+          ShardMessage message = {shard.globalIndex[shard.ownedCount + g], ghostShare[g]};
+          outgoing[shard.ghostOwner[g]].push_back(message);
+        }
+      }
+      sendToOwners(transport, shard.shardId, outgoing);
+      transport.exchange(shard.shardId, received);
+      int stray = 0;
+      for(size_t i = 0; i < received.size(); i++)
+      {
+        int local = ownedLocal(shard, received[i].vertex);
+        if(local == -1)
+          stray++;
+        else
+          incoming[local] += received[i].value;
+      }
+      reportStrayMessages(shard.shardId, stray);
+
+      double spread = transport.sumAcrossShards(shard.shardId, dangling) / vertices;
+      double change = 0;
+      for(int u = 0; u < shard.ownedCount; u++)
+      {
+        double updated = (1 - damping) / vertices + damping * (incoming[u] + spread);
+        change += std::fabs(updated - rank[u]);
+        rank[u] = updated;
+      }
+      if(tolerance > 0 && transport.sumAcrossShards(shard.shardId, change) < tolerance)
+        break;
+    }
+    return rank;
+  }
+
+  /**
+  * Function: runShardsLocally
+  * Description: runs func(shard, transport) for every shard on its own
+  *              thread, connected by a LocalTransport
+  * Function input: the shards and a callable
+  * Function output: none
+  * Postcondition: every call has returned
+  */
+  template<class Type, class Func>
+  void runShardsLocally(const std::vector<GraphShard<Type> >& shards, Func func)
+  {
+    LocalTransport transport(static_cast<int>(shards.size()));
+    std::vector<std::thread> workers;
+    for(size_t s = 0; s < shards.size(); s++)
+    {
+      workers.push_back(std::thread([&, s]()
+      {
+        func(shards[s], static_cast<ShardTransport&>(transport));
+      }));
+    }
+    for(size_t s = 0; s < workers.size(); s++)
+      workers[s].join();
+  }
+
+  /**
+  * Function: gatherOwned
+  * Description: collects per-shard results for owned vertices into one
+  *              array indexed by vertex position in the whole graph
+  * Function input: the shards, one result array per shard, the number of
+  *                 positions and the value for positions no shard owns
+  * Function output: the combined results
+  */
+  template<class Type, class Value>
+  std::vector<Value> gatherOwned(const std::vector<GraphShard<Type> >& shards,
+                                 const std::vector<std::vector<Value> >& perShard, int positions, Value fill)
+  {
+    std::vector<Value> combined(positions, fill);
+    for(size_t s = 0; s < shards.size(); s++)
+    {
+      for(int local = 0; local < shards[s].ownedCount; local++)
+        combined[shards[s].globalIndex[local]] = perShard[s][local];
+    }
+    return combined;
+  }
+}
+#endif
@@ -0,0 +1,1129 @@
+#include "graph.h"
+#include <memory>
+#include <mutex>
+
+/**
+ * File: temporal_graph.h
+ * Description: This file contains the definition and implementation of the
+ *              TemporalGraph class, a multi-version adjacency store that
+ *              keeps timestamped edge insertions and deletions, and of
+ *              TemporalSnapshot, a frozen read-only version of it that
+ *              answers queries as of any retained time.
+ */
+
+#ifndef _TEMPORAL_GRAPH_H_
+#define _TEMPORAL_GRAPH_H_
+
+namespace GraphNameSpace
+{
+    typedef long long Timestamp;
+    const Timestamp FOREVER = LLONG_MAX; // deletion time of something never deleted
+
+  /**
+  * Description: One version of an edge, visible at times t with
+  * insertedAt <= t < deletedAt
+  */
+    struct TemporalEdge
+    {
+      int connIndex; // position of the vertex on the other end of the edge
+      int edgeWeight; // weight if its a weighted graph
+      Timestamp insertedAt; // when the edge was inserted
+      Timestamp deletedAt; // when the edge was deleted, FOREVER if it still exists
+    };
+
+  /**
+  * Description: A fixed size block of edge versions. Blocks are shared
+  * between the live store and its snapshots and copied before a write when
+  * shared (copy on write).
+  */
+    struct TemporalEdgeBlock
+    {
+      static const int CAPACITY = 32;
+
+      int used; // number of edges in the block
+      TemporalEdge edge[CAPACITY]; // the edges
+    };
+
+  /**
+  * Description: A vertex together with the history of its adjacency list
+  */
+    template<class Type>
+    struct TemporalVertex
+    {
+      Type info; // info held by the vertex
+      Timestamp createdAt; // when the vertex was inserted
+      Timestamp deletedAt; // when the vertex was deleted, FOREVER if it still exists
+      std::vector<std::shared_ptr<TemporalEdgeBlock> > blocks; // edge versions in insertion order
+    };
+
+  /**
+  * Function: sharedWithSnapshot
+  * Description: checks if a snapshot still holds a record, so it must be
+  *              copied before it is written. use_count is a relaxed load, so
+  *              when it says one a reference is taken and dropped: dropping
+  *              it acquires the count, which orders the caller's write after
+  *              the reads of the snapshot that brought the count down.
+  */
+  template<class Record>
+  inline bool sharedWithSnapshot(const std::shared_ptr<Record>& record)
+  {
+    if(record.use_count() > 1)
+      return true;
+    std::shared_ptr<Record> acquired(record);
+    return false;
+  }
+
+  /**
+  * Description: An array shared between a TemporalGraph and its snapshots.
+  * The items are kept in chunks of CHUNK under a tree of CHUNK-wide nodes;
+  * copying the array copies one pointer, and writing an item copies only
+  * the chunk and the nodes above it that a copy still shares, so a snapshot
+  * costs O(1) and the first write after it O(CHUNK log n). A chunk can be
+  * dropped to free it, its items then read as the fill value.
+  */
+    template<class Item>
+    class ChunkedArray
+    {
+    public:
+      static const int SHIFT = 6;
+      static const size_t CHUNK = size_t(1) << SHIFT; // items per chunk, children per node
+
+      explicit ChunkedArray(const Item& fill = Item()) : count(0), depth(0), fill(fill) {}
+
+    /**
+      * Function: size / operator[] / writable / push_back / dropChunk
+      * Description: the number of items, an item to read, an item to
+      *              write (copying what a copy shares), appending an item,
+      *              and forgetting the chunk that holds an item
+      */
+      size_t size() const { return count; }
+      const Item& operator[](size_t index) const;
+      Item& writable(size_t index);
+      void push_back(const Item& item);
+      void dropChunk(size_t index);
+
+    private:
+      struct Node
+      {
+        std::vector<std::shared_ptr<Node> > children; // CHUNK of them above the chunks
+        std::vector<Item> items; // CHUNK of them in a chunk
+      };
+
+      size_t count; // items in the array
+      int depth; // levels of nodes above the chunks
+      Item fill; // what the items of a missing chunk read as
+      std::shared_ptr<Node> root; // null while empty
+    };
+
+  template<class Item>
+  const Item& ChunkedArray<Item>::operator[](size_t index) const
+  {
+    const Node* node = root.get();
+    for(int level = depth; node != 0 && level > 0; level--)
+      node = node->children[(index >> (SHIFT * level)) & (CHUNK - 1)].get();
+    return node == 0 ? fill : node->items[index & (CHUNK - 1)];
+  }
+
+  template<class Item>
+  Item& ChunkedArray<Item>::writable(size_t index)
+  {
+    std::shared_ptr<Node>* slot = &root;
+    for(int level = depth; ; level--)
+    {
+      if(!*slot)
+      {
+        *slot = std::make_shared<Node>();
+        if(level == 0)
+          (*slot)->items.assign(CHUNK, fill);
+        else
+          (*slot)->children.resize(CHUNK);
+      }
+      else if(sharedWithSnapshot(*slot))
+        *slot = std::make_shared<Node>(**slot);
+      if(level == 0)
+        return (*slot)->items[index & (CHUNK - 1)];
+      slot = &(*slot)->children[(index >> (SHIFT * level)) & (CHUNK - 1)];
+    }
+  }
+
+  template<class Item>
+  void ChunkedArray<Item>::push_back(const Item& item)
+  {
+    if(count == (CHUNK << (SHIFT * depth)))
+    {
+      // full, the old tree becomes the first child of a new root
+      std::shared_ptr<Node> grown = std::make_shared<Node>();
+      grown->children.resize(CHUNK);
+      grown->children[0] = root;
+      root = grown;
+      depth++;
+    }
+    count++;
+    writable(count - 1) = item;
+  }
+
+  template<class Item>
+  void ChunkedArray<Item>::dropChunk(size_t index)
+  {
+    std::shared_ptr<Node>* slot = &root;
+    for(int level = depth; level > 0 && *slot; level--)
+    {
+      if(sharedWithSnapshot(*slot))
+        *slot = std::make_shared<Node>(**slot);
+      slot = &(*slot)->children[(index >> (SHIFT * level)) & (CHUNK - 1)];
+    }
+    slot->reset();
+  }
+
+  /**
+  * Description: The positions that ever held each key of a TemporalGraph,
+  * a hash table whose buckets are shared with the snapshots through a
+  * ChunkedArray, so a write copies one bucket and the path to it. It
+  * doubles its buckets when they hold two keys each on average.
+  */
+    template<class Type>
+    class TemporalKeyIndex
+    {
+    public:
+      TemporalKeyIndex() : keys(0)
+      {
+        for(int b = 0; b < 16; b++)
+          buckets.push_back(std::shared_ptr<Bucket>());
+      }
+
+    /**
+      * Function: find / add / remove
+      * Description: the positions of a key (null if it has none), and
+      *              adding or removing one position of a key
+      */
+      const std::vector<int>* find(const Type& vertex) const;
+      void add(const Type& vertex, int position);
+      void remove(const Type& vertex, int position);
+
+    private:
+      typedef std::vector<std::pair<Type, std::vector<int> > > Bucket;
+
+      size_t bucketOf(const Type& vertex) const
+      {
+        return static_cast<size_t>(mixHash64(VertexKeyHash<Type>()(vertex))) & (buckets.size() - 1);
+      }
+
+      Bucket& writableBucket(size_t bucket);
+
+      ChunkedArray<std::shared_ptr<Bucket> > buckets; // a power of two of them, null when empty
+      size_t keys; // keys with at least one position
+    };
+
+  template<class Type>
+  const std::vector<int>* TemporalKeyIndex<Type>::find(const Type& vertex) const
+  {
+    const std::shared_ptr<Bucket>& bucket = buckets[bucketOf(vertex)];
+    if(!bucket)
+      return 0;
+    for(size_t i = 0; i < bucket->size(); i++)
+    {
+      if((*bucket)[i].first == vertex)
+        return &(*bucket)[i].second;
+    }
+    return 0;
+  }
+
+  template<class Type>
+  typename TemporalKeyIndex<Type>::Bucket& TemporalKeyIndex<Type>::writableBucket(size_t bucket)
+  {
+    std::shared_ptr<Bucket>& slot = buckets.writable(bucket);
+    if(!slot)
+      slot = std::make_shared<Bucket>();
+    else if(sharedWithSnapshot(slot))
+      slot = std::make_shared<Bucket>(*slot);
+    return *slot;
+  }
+
+  template<class Type>
+  void TemporalKeyIndex<Type>::add(const Type& vertex, int position)
+  {
+    Bucket& bucket = writableBucket(bucketOf(vertex));
+    for(size_t i = 0; i < bucket.size(); i++)
+    {
+      if(bucket[i].first == vertex)
+      {
+        bucket[i].second.push_back(position);
+        return;
+      }
+    }
+    bucket.push_back(std::make_pair(vertex, std::vector<int>(1, position)));
+    keys++;
+    if(keys <= 2 * buckets.size())
+      return;
+
+    // rehash into twice the buckets, amortized over the keys added since the last time
+    ChunkedArray<std::shared_ptr<Bucket> > old = buckets;
+    buckets = ChunkedArray<std::shared_ptr<Bucket> >();
+    for(size_t b = 0; b < 2 * old.size(); b++)
+      buckets.push_back(std::shared_ptr<Bucket>());
+    for(size_t b = 0; b < old.size(); b++)
+    {
+      if(!old[b])
+        continue;
+      for(size_t i = 0; i < old[b]->size(); i++)
+        writableBucket(bucketOf((*old[b])[i].first)).push_back((*old[b])[i]);
+    }
+  }
+
+  template<class Type>
+  void TemporalKeyIndex<Type>::remove(const Type& vertex, int position)
+  {
+    const std::vector<int>* positions = find(vertex);
+    if(positions == 0 || std::find(positions->begin(), positions->end(), position) == positions->end())
+      return;
+    Bucket& bucket = writableBucket(bucketOf(vertex));
+    for(size_t i = 0; i < bucket.size(); i++)
+    {
+      if(!(bucket[i].first == vertex))
+        continue;
+      std::vector<int>& held = bucket[i].second;
+      held.erase(std::find(held.begin(), held.end(), position));
+      if(held.empty())
+      {
+        bucket[i] = bucket.back();
+        bucket.pop_back();
+        keys--;
+      }
+      return;
+    }
+  }
+
+  /**
+  * Function: releasedVertex
+  * Description: the record every vertex released by collectGarbage shares,
+  *              visible at no time
+  */
+  template<class Type>
+  const std::shared_ptr<TemporalVertex<Type> >& releasedVertex()
+  {
+    static const std::shared_ptr<TemporalVertex<Type> > released = []()
+    {
+      std::shared_ptr<TemporalVertex<Type> > record = std::make_shared<TemporalVertex<Type> >();
+      record->info = Type();
+      record->createdAt = FOREVER;
+      record->deletedAt = FOREVER;
+      return record;
+    }();
+    return released;
+  }
+
+  /**
+  * Description: A frozen version of a TemporalGraph as of one time. It holds
+  * its own references to the blocks it was taken from, so later writes and
+  * garbage collection on the TemporalGraph never change what it sees. It has
+  * the same iteration interface as Graph, so the generic algorithms
+  * (kruskalSpanningForest, kahnTopologicalSort, dagPaths, ...) run on it.
+  */
+    template<class Type>
+    class TemporalSnapshot
+    {
+    public:
+      typedef ChunkedArray<std::shared_ptr<TemporalVertex<Type> > > VertexTable;
+      typedef TemporalKeyIndex<Type> KeyIndex;
+
+      TemporalSnapshot(const VertexTable& vertices, const KeyIndex& keys, Timestamp at, Weight weigh, Direction direction)
+        : weigh(weigh), direction(direction), vertices(vertices), keys(keys), at(at)
+      {
+      }
+
+    /**
+      * Function: time
+      * Description: returns the time the snapshot shows the graph at
+      */
+      Timestamp time() const { return at; }
+
+    /**
+      * Function: findVertex
+      * Description: finds the position of the vertex that had this info at
+      *              the time of the snapshot
+      * Function input: a vertex
+      * Function output: its position, -1 if it didn't exist then
+      */
+      int findVertex(const Type& vertex) const;
+
+    /**
+      * Function: isAdjacentTo
+      * Description: checks if there was an edge between two vertices
+      * Function input: two vertices
+      * Function output: None.
+      * Precondition: the vertices should have existed at the time
+      * Postcondition: returns true if adjancency existed or false otherwise
+      */
+      bool isAdjacentTo(const Type&, const Type&) const throw (std::logic_error);
+
+    /**
+      * Function: edgeWeight
+      * Description: returns the weight the edge between 2 vertices had
+      * Function input: two vertices
+      * Function output: the weight of the edge, -1 if there was none
+      * Precondition: the edge should have existed at the time
+      * Postcondition: the weight of the edge is returned
+      */
+      int edgeWeight(const Type&, const Type&) const throw (std::logic_error);
+
+    /**
+      * Function: breadthFirst
+      * Description: counts the edges on a shortest path from a vertex to
+      *              every vertex, following edge directions
+      * Function input: the start vertex
+      * Function output: the distance per position, -1 if unreachable
+      * Precondition: the vertex should have existed at the time
+      * Postcondition: the distances are returned, all -1 if the vertex
+      *                didn't exist
+      */
+      std::vector<int> breadthFirst(const Type&) const throw (std::logic_error);
+
+    /**
+      * Function: materialize
+      * Description: copies the snapshot into a Graph, vertices keep their
+      *              relative order
+      */
+      Graph<Type> materialize() const;
+
+      // the iteration interface shared with Graph; positions of vertices
+      // that didn't exist at the time are skipped, and the counts walk the
+      // vertex table and the edges to leave them out
+      int positionCount() const { return static_cast<int>(vertices.size()); }
+      int vertexCount() const; // vertices that existed at the time
+      bool containsVertex(int vertexIndex) const;
+      int edgeCount() const; // edges that existed at the time, undirected ones once
+      const Type& infoAt(int vertexIndex) const { return vertices[vertexIndex]->info; }
+
+      template<class Func>
+      void forEachVertex(Func func) const;
+
+      template<class Func>
+      void forEachNeighbor(int vertexIndex, Func func) const;
+
+      template<class Func>
+      void forEachEdge(Func func) const;
+
+      Weight weigh;  // is graph weighted?
+      Direction direction; // is the graph directed?
+
+    private:
+      VertexTable vertices; // the vertices as of the snapshot
+      KeyIndex keys; // positions that ever held each key
+      Timestamp at; // the time being viewed
+    };
+
+  /**
+  * Description: A graph that remembers its history. Every insertion and
+  * deletion carries a timestamp, timestamps never go backwards, and any
+  * time not older than the retained horizon can be queried or turned into
+  * a snapshot. Vertex positions are never reused or shifted.
+  *
+  * The adjacency lists are stored as blocks of edge versions, and the
+  * vertex table and key index as ChunkedArrays, all shared with the
+  * snapshots; a write copies only the block, chunk or bucket it touches
+  * (and the path to it), and only when a snapshot still holds it. Vertices
+  * released by collectGarbage share one record, and a chunk of them is
+  * freed. All members are safe to call from several
+  * threads; a snapshot needs no locking once taken.
+  */
+    template<class Type>
+    class TemporalGraph
+    {
+    public:
+      typedef typename TemporalSnapshot<Type>::VertexTable VertexTable;
+      typedef typename TemporalSnapshot<Type>::KeyIndex KeyIndex;
+
+    /**
+      * Function: TemporalGraph - The overloaded constructor with direction and weight
+      * Description: Constructs an empty temporal graph
+      * Function input: direction and weight of the graph
+      * Function output: None.
+      * Precondition: none.
+      * Postcondition: TemporalGraph object created with no history
+      */
+      TemporalGraph(Direction, Weight);
+
+    /**
+      * Function: TemporalGraph - The overloaded constructor with a graph
+      * Description: Constructs a temporal graph whose history starts with
+      *              the vertices and edges of a graph
+      * Function input: the graph and the time of its state
+      * Function output: None.
+      * Precondition: none.
+      * Postcondition: everything in the graph is inserted at that time
+      */
+      TemporalGraph(const Graph<Type>& graph, Timestamp at);
+
+    /**
+      * Function: insertVertex / deleteVertex / insertEdge / deleteEdge
+      * Description: record a change at a time. Deleting a vertex deletes
+      *              its edges at the same time; its info may be inserted
+      *              again later as a new vertex.
+      * Function input: the vertices, the weight and the time
+      * Function output: none
+      * Precondition: the time should not be earlier than the last change,
+      *               the vertices and edges should exist at that time
+      * Postcondition: the change is recorded, errors are printed
+      */
+      void insertVertex(const Type&, Timestamp at) throw (std::logic_error);
+      void deleteVertex(const Type&, Timestamp at) throw (std::logic_error);
+      void insertEdge(const Type&, const Type&, int weight, Timestamp at) throw (std::logic_error);
+      void deleteEdge(const Type&, const Type&, Timestamp at) throw (std::logic_error);
+
+    /**
+      * Function: isAdjacentTo / edgeWeight
+      * Description: point in time versions of the Graph queries
+      * Function input: two vertices and the time
+      * Function output: as for Graph
+      * Precondition: the time should not be older than the horizon
+      * Postcondition: the answer as of that time is returned
+      */
+      bool isAdjacentTo(const Type&, const Type&, Timestamp at) const throw (std::logic_error);
+      int edgeWeight(const Type&, const Type&, Timestamp at) const throw (std::logic_error);
+
+    /**
+      * Function: snapshot
+      * Description: freezes the graph as of a time. Costs a few references
+      *              to the vertex table and the key index, whatever their size.
+      * Function input: the time
+      * Function output: the snapshot
+      * Precondition: the time should not be older than the horizon
+      * Postcondition: the snapshot is returned, later changes don't affect it
+      */
+      TemporalSnapshot<Type> snapshot(Timestamp at) const throw (std::logic_error);
+
+    /**
+      * Function: collectGarbage
+      * Description: forgets the versions that are not visible at any time
+      *              from the horizon on, snapshots already taken keep theirs.
+      *              A vertex deleted by then keeps its position but loses
+      *              its info and its entry in the key index.
+      * Function input: the new horizon
+      * Function output: the number of edge versions dropped
+      * Precondition: none
+      * Postcondition: times older than the horizon can no longer be queried
+      */
+      long long collectGarbage(Timestamp horizon);
+
+    /**
+      * Function: horizon / latest
+      * Description: the oldest time that can be queried and the time of
+      *              the last change
+      */
+      Timestamp horizon() const;
+      Timestamp latest() const;
+
+      Weight weigh;  // is graph weighted?
+      Direction direction; // is the graph directed?
+
+    private:
+      /**
+      * Function: findVertexAt
+      * Description: position of the vertex with this info alive at a time, -1 if none
+      */
+      int findVertexAt(const Type& vertex, Timestamp at) const;
+
+      /**
+      * Function: checkTime
+      * Description: throws if a change is older than the last one
+      */
+      void checkTime(Timestamp at) const throw (std::logic_error);
+
+      /**
+      * Function: writableVertex / writableBlock
+      * Description: copy a vertex or a block a snapshot still shares
+      *              before it is written
+      */
+      TemporalVertex<Type>& writableVertex(int vertexIndex);
+      TemporalEdgeBlock& writableBlock(int vertexIndex, int block);
+
+      /**
+      * Function: appendEdge / closeEdge
+      * Description: add an edge version to a vertex, or end the first
+      *              live version pointing at a vertex
+      */
+      void appendEdge(int vertexIndex, int connIndex, int weight, Timestamp at);
+      bool closeEdge(int vertexIndex, int connIndex, Timestamp at);
+
+      VertexTable vertices; // every vertex ever inserted, released ones share one record
+      KeyIndex keys; // positions that ever held each key
+      Timestamp newest; // time of the last change
+      Timestamp oldest; // the horizon
+      mutable std::mutex lock; // guards everything above
+    };
+
+  /**
+  * Function: edgeVisible / vertexVisible
+  * Description: checks if a version existed at a time
+  */
+  inline bool edgeVisible(const TemporalEdge& edge, Timestamp at)
+  {
+    return edge.insertedAt <= at && at < edge.deletedAt;
+  }
+
+  template<class Type>
+  inline bool vertexVisible(const TemporalVertex<Type>& vertex, Timestamp at)
+  {
+    return vertex.createdAt <= at && at < vertex.deletedAt;
+  }
+
+  /**
+  * Function: findVisibleVertex
+  * Description: looks a key up among the positions that ever held it
+  */
+  template<class Type>
+  int findVisibleVertex(const typename TemporalSnapshot<Type>::VertexTable& vertices,
+                        const typename TemporalSnapshot<Type>::KeyIndex& keys, const Type& vertex, Timestamp at)
+  {
+    const std::vector<int>* found = keys.find(vertex);
+    if(found == 0)
+      return -1;
+    for(size_t i = found->size(); i-- > 0; )
+    {
+      int position = (*found)[i];
+      if(position < static_cast<int>(vertices.size()) && vertexVisible(*vertices[position], at))
+        return position;
+    }
+    return -1;
+  }
+
+  /**
+  * Function: findVisibleEdge
+  * Description: finds the version of an edge visible at a time
+  * Function output: the version, or null if there is none
+  */
+  template<class Type>
+  const TemporalEdge* findVisibleEdge(const TemporalVertex<Type>& vertex, int connIndex, Timestamp at)
+  {
+    for(size_t b = 0; b < vertex.blocks.size(); b++)
+    {
+      const TemporalEdgeBlock& block = *vertex.blocks[b];
+      for(int e = 0; e < block.used; e++)
+      {
+        if(block.edge[e].connIndex == connIndex && edgeVisible(block.edge[e], at))
+          return &block.edge[e];
+      }
+    }
+    return 0;
+  }
+
+  template<class Type>
+  int TemporalSnapshot<Type>::findVertex(const Type& vertex) const
+  {
+    return findVisibleVertex(vertices, keys, vertex, at);
+  }
+
+  template<class Type>
+  bool TemporalSnapshot<Type>::containsVertex(int vertexIndex) const
+  {
+    return vertexIndex >= 0 && vertexIndex < positionCount() && vertexVisible(*vertices[vertexIndex], at);
+  }
+
+  template<class Type>
+  int TemporalSnapshot<Type>::vertexCount() const
+  {
+    int visible = 0;
+    for(int v = 0; v < positionCount(); v++)
+      visible += containsVertex(v);
+    return visible;
+  }
+
+  template<class Type>
+  int TemporalSnapshot<Type>::edgeCount() const
+  {
+    int edges = 0;
+    for(int v = 0; v < positionCount(); v++)
+      forEachEdgeOnce(*this, v, [&](int, int) { edges++; });
+    return edges;
+  }
+
+  template<class Type>
+  template<class Func>
+  inline void TemporalSnapshot<Type>::forEachVertex(Func func) const
+  {
+    for(int v = 0; v < positionCount(); v++)
+    {
+      if(containsVertex(v))
+        func(v, vertices[v]->info);
+    }
+  }
+
+  template<class Type>
+  template<class Func>
+  inline void TemporalSnapshot<Type>::forEachNeighbor(int vertexIndex, Func func) const
+  {
+    if(!containsVertex(vertexIndex))
+      return;
+    const TemporalVertex<Type>& vertex = *vertices[vertexIndex];
+    for(size_t b = 0; b < vertex.blocks.size(); b++)
+    {
+      const TemporalEdgeBlock& block = *vertex.blocks[b];
+      for(int e = 0; e < block.used; e++)
+      {
+        if(edgeVisible(block.edge[e], at))
+          func(block.edge[e].connIndex, block.edge[e].edgeWeight);
+      }
+    }
+  }
+
+  template<class Type>
+  template<class Func>
+  inline void TemporalSnapshot<Type>::forEachEdge(Func func) const
+  {
+    for(int v = 0; v < positionCount(); v++)
+    {
+      forEachNeighbor(v, [&](int connIndex, int edgeWeight)
+      {
+        func(v, connIndex, edgeWeight);
+      });
+    }
+  }
+
+  template<class Type>
+  bool TemporalSnapshot<Type>::isAdjacentTo(const Type& fromVertex, const Type& toVertex) const throw (std::logic_error)
+  {
+    int indexFrom = findVertex(fromVertex);
+    int indexTo = findVertex(toVertex);
+    try
+    {
+      if(indexFrom == -1 || indexTo == -1)
+        throw std::logic_error("Either or both of the vertices didn't exist at that time. Cannot check adjacency");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return false;
+    }
+    return findVisibleEdge(*vertices[indexFrom], indexTo, at) != 0;
+  }
+
+  template<class Type>
+  int TemporalSnapshot<Type>::edgeWeight(const Type& fromVertex, const Type& toVertex) const throw (std::logic_error)
+  {
+    int indexFrom = findVertex(fromVertex);
+    int indexTo = findVertex(toVertex);
+    const TemporalEdge* edge = 0;
+    try
+    {
+      if(indexFrom != -1 && indexTo != -1)
+        edge = findVisibleEdge(*vertices[indexFrom], indexTo, at);
+      if(edge == 0)
+        throw std::logic_error("Following edege didn't exist at that time. -1");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return -1;
+    }
+    return edge->edgeWeight;
+  }
+
+  template<class Type>
+  std::vector<int> TemporalSnapshot<Type>::breadthFirst(const Type& source) const throw (std::logic_error)
+  {
+    std::vector<int> distance(positionCount(), -1);
+    int start = findVertex(source);
+    try
+    {
+      if(start == -1)
+        throw std::logic_error("Vertex didn't exist at that time. Cannot search from it");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return distance;
+    }
+
+    std::vector<int> queue(1, start);
+    distance[start] = 0;
+    for(size_t head = 0; head < queue.size(); head++)
+    {
+      int u = queue[head];
+      forEachNeighbor(u, [&](int connIndex, int)
+      {
+        if(distance[connIndex] == -1)
+        {
+          distance[connIndex] = distance[u] + 1;
+          queue.push_back(connIndex);
+        }
+      });
+    }
+    return distance;
+  }
+
+  template<class Type>
+  Graph<Type> TemporalSnapshot<Type>::materialize() const
+  {
+    Graph<Type> graph(direction, weigh);
+    std::vector<VertexHandle> handle(positionCount(), NO_VERTEX);
+    forEachVertex([&](int v, const Type& info)
+    {
+      handle[v] = graph.insertVertex(info);
+    });
+    for(int v = 0; v < positionCount(); v++)
+    {
+      forEachEdgeOnce(*this, v, [&](int connIndex, int edgeWeight)
+      {
+        if(handle[connIndex] != NO_VERTEX)
+          graph.insertEdge(handle[v], handle[connIndex], edgeWeight);
+      });
+    }
+    return graph;
+  }
+
+  template<class Type>
+  TemporalGraph<Type>::TemporalGraph(Direction dir, Weight weight)
+    : weigh(weight), direction(dir), vertices(releasedVertex<Type>()), newest(LLONG_MIN), oldest(LLONG_MIN)
+  {
+  }
+
+  template<class Type>
+  TemporalGraph<Type>::TemporalGraph(const Graph<Type>& graph, Timestamp at)
+    : weigh(graph.weigh), direction(graph.direction), vertices(releasedVertex<Type>()), newest(LLONG_MIN), oldest(LLONG_MIN)
+  {
+    std::vector<int> position(graph.vertexCount(), -1);
+    graph.forEachVertex([&](int vertexIndex, const Type& info)
+    {
+      insertVertex(info, at);
+      position[vertexIndex] = static_cast<int>(vertices.size()) - 1;
+    });
+    // the graph already holds undirected edges on both ends, copy the entries as they are
+    std::lock_guard<std::mutex> guard(lock);
+    graph.forEachEdge([&](int from, int to, int edgeWeight)
+    {
+      appendEdge(position[from], position[to], edgeWeight, at);
+    });
+  }
+
+  template<class Type>
+  void TemporalGraph<Type>::checkTime(Timestamp at) const throw (std::logic_error)
+  {
+    if(at < newest)
+      throw std::logic_error("Changes must not be older than the last change. Couldn't record it");
+  }
+
+  template<class Type>
+  int TemporalGraph<Type>::findVertexAt(const Type& vertex, Timestamp at) const
+  {
+    return findVisibleVertex(vertices, keys, vertex, at);
+  }
+
+  template<class Type>
+  TemporalVertex<Type>& TemporalGraph<Type>::writableVertex(int vertexIndex)
+  {
+    std::shared_ptr<TemporalVertex<Type> >& vertex = vertices.writable(vertexIndex);
+    if(sharedWithSnapshot(vertex))
+      vertex = std::make_shared<TemporalVertex<Type> >(*vertex);
+    return *vertex;
+  }
+
+  template<class Type>
+  TemporalEdgeBlock& TemporalGraph<Type>::writableBlock(int vertexIndex, int block)
+  {
+    TemporalVertex<Type>& vertex = writableVertex(vertexIndex);
+    if(sharedWithSnapshot(vertex.blocks[block]))
+      vertex.blocks[block] = std::make_shared<TemporalEdgeBlock>(*vertex.blocks[block]);
+    return *vertex.blocks[block];
+  }
+
+  template<class Type>
+  void TemporalGraph<Type>::appendEdge(int vertexIndex, int connIndex, int weight, Timestamp at)
+  {
+    TemporalVertex<Type>& vertex = writableVertex(vertexIndex);
+    if(vertex.blocks.empty() || vertex.blocks.back()->used == TemporalEdgeBlock::CAPACITY)
+    {
+      vertex.blocks.push_back(std::make_shared<TemporalEdgeBlock>());
+      vertex.blocks.back()->used = 0;
+    }
+    TemporalEdgeBlock& block = writableBlock(vertexIndex, static_cast<int>(vertex.blocks.size()) - 1);
+    TemporalEdge& edge = block.edge[block.used++];
+    edge.connIndex = connIndex;
+    edge.edgeWeight = weight;
+    edge.insertedAt = at;
+    edge.deletedAt = FOREVER;
+  }
+
+  template<class Type>
+  bool TemporalGraph<Type>::closeEdge(int vertexIndex, int connIndex, Timestamp at)
+  {
+    const TemporalVertex<Type>& vertex = *vertices[vertexIndex];
+    for(size_t b = 0; b < vertex.blocks.size(); b++)
+    {
+      const TemporalEdgeBlock& block = *vertex.blocks[b];
+      for(int e = 0; e < block.used; e++)
+      {
+        if(block.edge[e].connIndex == connIndex && block.edge[e].deletedAt == FOREVER)
+        {
+          writableBlock(vertexIndex, static_cast<int>(b)).edge[e].deletedAt = at;
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  template<class Type>
+  void TemporalGraph<Type>::insertVertex(const Type& vertex, Timestamp at) throw (std::logic_error)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    try
+    {
+      checkTime(at);
+      if(findVertexAt(vertex, at) != -1)
+        throw std::logic_error("Item already exists in the Graph and will not be inserted");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return;
+    }
+
+    std::shared_ptr<TemporalVertex<Type> > created = std::make_shared<TemporalVertex<Type> >();
+    created->info = vertex;
+    created->createdAt = at;
+    created->deletedAt = FOREVER;
+    vertices.push_back(created);
+    keys.add(vertex, static_cast<int>(vertices.size()) - 1);
+    newest = at;
+  }
+
+  template<class Type>
+  void TemporalGraph<Type>::deleteVertex(const Type& vertex, Timestamp at) throw (std::logic_error)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    int vertexIndex = findVertexAt(vertex, at);
+    try
+    {
+      checkTime(at);
+      if(vertexIndex == -1)
+        throw std::logic_error("Vertex doesn't exist in the graph. Couldn't perform deletion");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return;
+    }
+
+    //first delete all the relationships that the vertex has with other vertices
+    for(size_t v = 0; v < vertices.size(); v++)
+    {
+      if(!vertexVisible(*vertices[v], at))
+        continue;
+      while(closeEdge(static_cast<int>(v), vertexIndex, at))
+      {
+      }
+    }
+    const TemporalVertex<Type>& own = *vertices[vertexIndex];
+    for(size_t b = 0; b < own.blocks.size(); b++)
+    {
+      for(int e = 0; e < own.blocks[b]->used; e++)
+      {
+        if(own.blocks[b]->edge[e].deletedAt == FOREVER)
+          writableBlock(vertexIndex, static_cast<int>(b)).edge[e].deletedAt = at;
+      }
+    }
+    writableVertex(vertexIndex).deletedAt = at;
+    newest = at;
+  }
+
+  template<class Type>
+  void TemporalGraph<Type>::insertEdge(const Type& fromVertex, const Type& toVertex, int weight, Timestamp at) throw (std::logic_error)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    int indexFrom = findVertexAt(fromVertex, at);
+    int indexTo = findVertexAt(toVertex, at);
+    try
+    {
+      checkTime(at);
+      if(indexFrom == -1 || indexTo == -1)
+        throw std::logic_error("Either or both of the vertices don't exist in the graph. Couldn't insert the edge");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return;
+    }
+
+    int storedWeight = (weigh == WEIGHTED) ? weight : 0;
+    appendEdge(indexFrom, indexTo, storedWeight, at);
+    if(direction == UNDIRECTED)
+      appendEdge(indexTo, indexFrom, storedWeight, at);
+    newest = at;
+  }
+
+  template<class Type>
+  void TemporalGraph<Type>::deleteEdge(const Type& fromVertex, const Type& toVertex, Timestamp at) throw (std::logic_error)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    int indexFrom = findVertexAt(fromVertex, at);
+    int indexTo = findVertexAt(toVertex, at);
+    try
+    {
+      checkTime(at);
+      if(indexFrom == -1 || indexTo == -1)
+        throw std::logic_error("Either or both of the vertices don't exist in the graph. Couldn't perform deletion");
+      if(!closeEdge(indexFrom, indexTo, at))
+        throw std::logic_error("Edge don't exist between the 2 vertices. Couldn't perform deletion");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return;
+    }
+
+    if(direction == UNDIRECTED)
+      closeEdge(indexTo, indexFrom, at);
+    newest = at;
+  }
+
+  template<class Type>
+  bool TemporalGraph<Type>::isAdjacentTo(const Type& fromVertex, const Type& toVertex, Timestamp at) const throw (std::logic_error)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    int indexFrom = findVertexAt(fromVertex, at);
+    int indexTo = findVertexAt(toVertex, at);
+    try
+    {
+      if(at < oldest)
+        throw std::logic_error("Time is older than the retained horizon. Cannot check adjacency");
+      if(indexFrom == -1 || indexTo == -1)
+        throw std::logic_error("Either or both of the vertices didn't exist at that time. Cannot check adjacency");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return false;
+    }
+    return findVisibleEdge(*vertices[indexFrom], indexTo, at) != 0;
+  }
+
+  template<class Type>
+  int TemporalGraph<Type>::edgeWeight(const Type& fromVertex, const Type& toVertex, Timestamp at) const throw (std::logic_error)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    int indexFrom = findVertexAt(fromVertex, at);
+    int indexTo = findVertexAt(toVertex, at);
+    const TemporalEdge* edge = 0;
+    try
+    {
+      if(at < oldest)
+        throw std::logic_error("Time is older than the retained horizon. -1");
+      if(indexFrom != -1 && indexTo != -1)
+        edge = findVisibleEdge(*vertices[indexFrom], indexTo, at);
+      if(edge == 0)
+        throw std::logic_error("Following edege didn't exist at that time. -1");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return -1;
+    }
+    return edge->edgeWeight;
+  }
+
+  template<class Type>
+  TemporalSnapshot<Type> TemporalGraph<Type>::snapshot(Timestamp at) const throw (std::logic_error)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    try
+    {
+      if(at < oldest)
+        throw std::logic_error("Time is older than the retained horizon. The snapshot will be empty");
+    }
+    catch(const std::logic_error bad_item)
+    {
+      cerr << "logic_error: " << bad_item.what() << '\n';
+      return TemporalSnapshot<Type>(VertexTable(releasedVertex<Type>()), KeyIndex(), at, weigh, direction);
+    }
+    return TemporalSnapshot<Type>(vertices, keys, at, weigh, direction);
+  }
+
+  template<class Type>
+  long long TemporalGraph<Type>::collectGarbage(Timestamp horizon)
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if(horizon <= oldest)
+      return 0;
+    oldest = horizon;
+
+    long long dropped = 0;
+    std::vector<size_t> releasedChunks; // chunks a vertex was released from
+    for(size_t v = 0; v < vertices.size(); v++)
+    {
+      const TemporalVertex<Type>& vertex = *vertices[v];
+      if(vertex.deletedAt <= horizon)
+      {
+        // gone for good: drop its key so the index doesn't grow with churn,
+        // and share the released record so its info and edges are freed
+        keys.remove(vertex.info, static_cast<int>(v));
+        for(size_t b = 0; b < vertex.blocks.size(); b++)
+          dropped += vertex.blocks[b]->used;
+        vertices.writable(v) = releasedVertex<Type>();
+        if(releasedChunks.empty() || releasedChunks.back() != v / VertexTable::CHUNK)
+          releasedChunks.push_back(v / VertexTable::CHUNK);
+        continue;
+      }
+
+      long long stale = 0;
+      for(size_t b = 0; b < vertex.blocks.size(); b++)
+      {
+        for(int e = 0; e < vertex.blocks[b]->used; e++)
+        {
+          if(vertex.blocks[b]->edge[e].deletedAt <= horizon)
+            stale++;
+        }
+      }
+      if(stale == 0)
+        continue;
+
+      // rebuild this vertex's blocks from the versions still visible, the old
+      // blocks stay alive for as long as a snapshot holds them
+      std::vector<std::shared_ptr<TemporalEdgeBlock> > compacted;
+      for(size_t b = 0; b < vertex.blocks.size(); b++)
+      {
+        for(int e = 0; e < vertex.blocks[b]->used; e++)
+        {
+          const TemporalEdge& edge = vertex.blocks[b]->edge[e];
+          if(edge.deletedAt <= horizon)
+            continue;
+          if(compacted.empty() || compacted.back()->used == TemporalEdgeBlock::CAPACITY)
+          {
+            compacted.push_back(std::make_shared<TemporalEdgeBlock>());
+            compacted.back()->used = 0;
+          }
+          compacted.back()->edge[compacted.back()->used++] = edge;
+        }
+      }
+      writableVertex(static_cast<int>(v)).blocks.swap(compacted);
+      dropped += stale;
+    }
+
+    // a chunk left with released vertices only is freed, its positions stay
+    for(size_t c = 0; c < releasedChunks.size(); c++)
+    {
+      size_t first = releasedChunks[c] * VertexTable::CHUNK;
+      size_t last = std::min(first + VertexTable::CHUNK, vertices.size());
+      size_t v = first;
+      while(v < last && vertices[v] == releasedVertex<Type>())
+        v++;
+      if(v == last)
+        vertices.dropChunk(first);
+    }
+    return dropped;
+  }
+
+  template<class Type>
+  Timestamp TemporalGraph<Type>::horizon() const
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    return oldest;
+  }
+
+  template<class Type>
+  Timestamp TemporalGraph<Type>::latest() const
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    return newest;
+  }
+}
+#endif
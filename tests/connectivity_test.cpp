@@ -0,0 +1,137 @@
+/**
+ * File: connectivity_test.cpp
+ * Description: Checks connected and reachable against a breadth first
+ *              search recomputed from scratch after every random insertion
+ *              and deletion, on directed and undirected graphs. Vertex
+ *              deletions renumber the remaining vertices, and the index is
+ *              built ahead of time, lazily, and dropped along the way.
+ *
+ *              make -C tests
+ */
+
+#include "../graph.h"
+#include <cassert>
+#include <map>
+#include <set>
+#include <thread>
+
+using namespace GraphNameSpace;
+
+typedef std::set<std::pair<int, int> > EdgeSet;
+
+// vertices reachable from source over the edges kept beside the graph
+std::set<int> searchFrom(int source, const EdgeSet& edges, bool undirected)
+{
+  std::map<int, std::vector<int> > adjacent;
+  for(EdgeSet::const_iterator it = edges.begin(); it != edges.end(); ++it)
+  {
+    adjacent[it->first].push_back(it->second);
+    if(undirected)
+      adjacent[it->second].push_back(it->first);
+  }
+  std::set<int> seen;
+  std::vector<int> queue(1, source);
+  seen.insert(source);
+  for(size_t head = 0; head < queue.size(); head++)
+  {
+    const std::vector<int>& next = adjacent[queue[head]];
+    for(size_t i = 0; i < next.size(); i++)
+      if(seen.insert(next[i]).second)
+        queue.push_back(next[i]);
+  }
+  return seen;
+}
+
+void checkAll(const Graph<int>& graph, const std::set<int>& vertices, const EdgeSet& edges, bool undirected)
+{
+  for(std::set<int>::const_iterator from = vertices.begin(); from != vertices.end(); ++from)
+  {
+    std::set<int> directed = searchFrom(*from, edges, false);
+    std::set<int> either = searchFrom(*from, edges, true);
+    for(std::set<int>::const_iterator to = vertices.begin(); to != vertices.end(); ++to)
+    {
+      assert(graph.connected(*from, *to) == (either.count(*to) == 1));
+      assert(graph.reachable(*from, *to) == ((undirected ? either : directed).count(*to) == 1));
+    }
+  }
+}
+
+int main()
+{
+  srand(11);
+  for(int round = 0; round < 12; round++)
+  {
+    bool undirected = round % 2 == 1;
+    Graph<int> graph(undirected ? UNDIRECTED : DIRECTED, UNWEIGHTED);
+    std::set<int> vertices;
+    EdgeSet edges;
+    if(round % 3 == 0)
+      graph.buildConnectivityIndex(true);
+
+    for(int step = 0; step < 1500; step++)
+    {
+      int a = rand() % 40, b = rand() % 40;
+      if(undirected && a > b)
+        std::swap(a, b);
+      int action = rand() % 10;
+      if(action < 2)
+      {
+        if(vertices.insert(a).second)
+          graph.insertVertex(a);
+      }
+      else if(action < 3)
+      {
+        // deleting a vertex moves another into its position
+        if(vertices.erase(a))
+        {
+          graph.deleteVertex(a);
+          for(EdgeSet::iterator it = edges.begin(); it != edges.end(); )
+          {
+            if(it->first == a || it->second == a)
+              edges.erase(it++);
+            else
+              ++it;
+          }
+        }
+      }
+      else if(action < 8)
+      {
+        if(vertices.count(a) && vertices.count(b) && edges.insert(std::make_pair(a, b)).second)
+          graph.insertEdge(a, b);
+      }
+      else if(action < 9)
+      {
+        if(edges.erase(std::make_pair(a, b)))
+          graph.deleteEdge(a, b);
+      }
+      else if(rand() % 4 == 0)
+        graph.dropConnectivityIndex();
+
+      assert(graph.vertexCount() == static_cast<int>(vertices.size()));
+      if(vertices.count(a) && vertices.count(b))
+      {
+        std::set<int> reached = searchFrom(a, edges, undirected);
+        std::set<int> either = searchFrom(a, edges, true);
+        assert(graph.connected(a, b) == (either.count(b) == 1));
+        assert(graph.reachable(a, b) == (reached.count(b) == 1));
+        assert(graph.reachable(graph.handleOf(a), graph.handleOf(b)) == (reached.count(b) == 1));
+      }
+      if(step % 40 == 39)
+        checkAll(graph, vertices, edges, undirected);
+    }
+    checkAll(graph, vertices, edges, undirected);
+
+    // readers started after buildConnectivityIndex share the built index
+    graph.insertVertex(1000);
+    vertices.insert(1000);
+    graph.buildConnectivityIndex(true);
+    std::vector<std::thread> readers;
+    for(int t = 0; t < 4; t++)
+      readers.push_back(std::thread([&]() { checkAll(graph, vertices, edges, undirected); }));
+    for(size_t t = 0; t < readers.size(); t++)
+      readers[t].join();
+  }
+
+  cout << "connectivity tests passed\n";
+  return 0;
+}
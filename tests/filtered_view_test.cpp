@@ -0,0 +1,118 @@
+/**
+ * File: filtered_view_test.cpp
+ * Description: Checks that walking a FilteredView sees the same vertices,
+ *              edges and counts as the graph materialize() copies out of it,
+ *              and that the generic algorithms agree on the two, for random
+ *              vertex masks and edge filters on graphs with a custom key hash.
+ *
+ *              make -C tests
+ */
+
+#include "../filtered_view.h"
+#include <cassert>
+#include <map>
+
+using namespace GraphNameSpace;
+
+struct CollidingHash
+{
+  size_t operator()(int key) const { return key % 3; }
+};
+
+struct OddSum
+{
+  bool operator()(int fromIndex, int toIndex, int) const { return (fromIndex + toIndex) % 2 == 1; }
+};
+
+typedef std::map<std::pair<int, int>, int> EdgeCounts;
+
+// (from, to) pairs with their multiplicity, positions mapped through rank
+template<class GraphType>
+EdgeCounts edgesOf(const GraphType& graph, const std::vector<int>& rank)
+{
+  EdgeCounts edges;
+  graph.forEachEdge([&](int fromIndex, int toIndex, int edgeWeight)
+  {
+    edges[std::make_pair(rank[fromIndex], rank[toIndex])] += edgeWeight + 1000;
+  });
+  return edges;
+}
+
+template<class View>
+void compare(const View& view, const Graph<int, CollidingHash>& graph)
+{
+  Graph<int, CollidingHash> copy = view.materialize(2);
+  assert(view.positionCount() == graph.vertexCount());
+  assert(view.vertexCount() == copy.vertexCount());
+  assert(view.edgeCount() == copy.edgeCount());
+  assert(view.weigh == copy.weigh && view.direction == copy.direction);
+
+  // positions of the view map onto the copy in order
+  std::vector<int> rank(view.positionCount(), -1), identity(copy.vertexCount());
+  int next = 0;
+  view.forEachVertex([&](int vertexIndex, const int& info)
+  {
+    assert(view.containsVertex(vertexIndex));
+    assert(copy.infoAt(next) == info && copy.findVertex(info) == next);
+    identity[next] = next;
+    rank[vertexIndex] = next++;
+  });
+  assert(next == copy.vertexCount());
+  for(int i = 0; i < view.positionCount(); i++)
+  {
+    if(!view.containsVertex(i))
+      view.forEachNeighbor(i, [](int, int) { assert(false); });
+  }
+  assert(edgesOf(view, rank) == edgesOf(copy, identity));
+
+  if(view.direction == UNDIRECTED)
+  {
+    assert(kruskalSpanningForest(view, 2).totalWeight == kruskalSpanningForest(copy, 2).totalWeight);
+    assert(boruvkaSpanningForest(view, 3).totalWeight == kruskalSpanningForest(copy, 1).totalWeight);
+  }
+  else
+  {
+    TopologicalOrder viewOrder = kahnTopologicalSort(view, 2), copyOrder = kahnTopologicalSort(copy, 1);
+    assert(viewOrder.acyclic == copyOrder.acyclic && viewOrder.order.size() == copyOrder.order.size());
+    for(size_t i = 0; i < viewOrder.order.size(); i++)
+      assert(rank[viewOrder.order[i]] == copyOrder.order[i]);
+  }
+}
+
+int main()
+{
+  srand(17);
+  for(int round = 0; round < 40; round++)
+  {
+    Graph<int, CollidingHash> graph(round % 2 ? DIRECTED : UNDIRECTED, WEIGHTED);
+    int n = 1 + rand() % 90;
+    for(int i = 0; i < n; i++)
+      graph.insertVertex(i * 7);
+    int edges = rand() % (3 * n);
+    for(int k = 0; k < edges; k++)
+    {
+      // forward edges only in odd rounds, so some directed graphs are acyclic
+      int a = rand() % n, b = rand() % n;
+      if(round % 4 == 1 && a > b)
+        std::swap(a, b);
+      if(graph.neighborsAt(a).size() < 90 && graph.neighborsAt(b).size() < 90)
+        graph.insertEdge(a * 7, b * 7, rand() % 20);
+    }
+
+    std::vector<unsigned long long> mask((n + 63) / 64 + 1, 0);
+    for(int i = 0; i < n + 64; i++)
+      if(rand() % 3 != 0)
+        mask[i / 64] |= 1ULL << (i % 64);
+    compare(FilteredView<int, AllEdges, CollidingHash>(graph), graph);
+    compare(FilteredView<int, AllEdges, CollidingHash>(graph, mask), graph);
+    compare(filterGraph(graph, [](int, int info) { return info % 5 != 0; }, MinimumWeight(8)), graph);
+    FilteredView<int, OddSum, CollidingHash> odd = filterEdges(graph, OddSum());
+    odd.excludeVertex(0);
+    compare(odd, graph);
+    odd.includeVertex(0);
+    compare(odd, graph);
+  }
+
+  cout << "filtered view tests passed\n";
+  return 0;
+}
@@ -0,0 +1,102 @@
+/**
+ * File: graph_export_test.cpp
+ * Description: Checks that GraphWriter writes the same bytes in all four
+ *              formats whatever the number of threads and the chunk size,
+ *              that labels are escaped for DOT and JSON each their own way,
+ *              and that views and snapshots are written without the
+ *              vertices they leave out.
+ *
+ *              make -C tests
+ */
+
+#include "../filtered_view.h"
+#include "../graph_export.h"
+#include "../temporal_graph.h"
+#include <cassert>
+
+using namespace GraphNameSpace;
+
+const ExportFormat FORMATS[4] = {EDGE_LIST, DOT, JSON, BINARY};
+
+template<class GraphType>
+std::string exported(const GraphType& graph, ExportFormat format, int threads, int verticesPerChunk)
+{
+  GraphWriter<std::string> writer(threads, verticesPerChunk);
+  std::ostringstream out;
+  writer.write(graph, out, format);
+  return out.str();
+}
+
+template<class GraphType>
+void checkDeterministic(const GraphType& graph)
+{
+  const int THREADS[4] = {1, 2, 3, 8};
+  const int CHUNKS[5] = {1, 2, 5, 64, 4096};
+  for(int f = 0; f < 4; f++)
+  {
+    std::string expected = exported(graph, FORMATS[f], 1, 1 << 20);
+    assert(!expected.empty());
+    for(int t = 0; t < 4; t++)
+      for(int c = 0; c < 5; c++)
+        assert(exported(graph, FORMATS[f], THREADS[t], CHUNKS[c]) == expected);
+  }
+}
+
+int main()
+{
+  srand(3);
+  for(int round = 0; round < 4; round++)
+  {
+    Graph<std::string> graph(round % 2 ? DIRECTED : UNDIRECTED, round < 2 ? WEIGHTED : UNWEIGHTED);
+    for(int i = 0; i < 90; i++)
+      graph.insertVertex("v" + std::to_string(i) + (i % 9 == 0 ? "\"\\\n\t" : ""));
+    for(int k = 0; k < 300; k++)
+    {
+      int a = rand() % 90, b = k % 17 == 0 ? a : rand() % 90;
+      if(graph.neighborsAt(a).size() < 90 && graph.neighborsAt(b).size() < 90)
+        graph.insertEdge(graph.handleAt(a), graph.handleAt(b), rand() % 1000 - 500);
+    }
+    checkDeterministic(graph);
+    checkDeterministic(filterVertices(graph, [](int vertexIndex, const std::string&) { return vertexIndex % 3 != 1; }));
+  }
+
+  // each format escapes a label its own way
+  Graph<std::string> labels(DIRECTED, UNWEIGHTED);
+  labels.insertVertex("a\"b\\c\x01" "d\ne");
+  std::string dot = exported(labels, DOT, 1, 1);
+  assert(dot.find("[label=\"a\\\"b\\\\c\x01" "d\ne\"]") != std::string::npos);
+  assert(dot.find("\\u") == std::string::npos);
+  std::string json = exported(labels, JSON, 1, 1);
+  assert(json.find("\"info\":\"a\\\"b\\\\c\\u0001d\\ne\"") != std::string::npos);
+
+  // a view leaves out hidden vertices and their edges
+  Graph<std::string> path(UNDIRECTED, UNWEIGHTED);
+  for(int i = 0; i < 5; i++)
+    path.insertVertex("p" + std::to_string(i));
+  for(int i = 0; i < 4; i++)
+    path.insertEdge(path.handleAt(i), path.handleAt(i + 1));
+  FilteredView<std::string> view = filterVertices(path, [](int vertexIndex, const std::string&) { return vertexIndex != 2; });
+  assert(exported(view, EDGE_LIST, 2, 1) == "0 1\n3 4\n");
+  std::string viewDot = exported(view, DOT, 2, 1);
+  assert(viewDot.find("\"p2\"") == std::string::npos && viewDot.find("\"p3\"") != std::string::npos);
+  std::string viewBinary = exported(view, BINARY, 2, 1);
+  assert(viewBinary.size() == 8 + 4 + 4 + 8 + 5 * 4 + 4 * 8);
+
+  // so does a snapshot for vertices that didn't exist at its time
+  TemporalGraph<std::string> history(UNDIRECTED, WEIGHTED);
+  history.insertVertex("x", 1);
+  history.insertVertex("y", 1);
+  history.insertEdge("x", "y", 7, 2);
+  history.insertVertex("z", 3);
+  history.insertEdge("y", "z", 9, 3);
+  history.deleteVertex("x", 4);
+  TemporalSnapshot<std::string> before = history.snapshot(3), after = history.snapshot(5);
+  checkDeterministic(before);
+  assert(exported(before, EDGE_LIST, 1, 1) == "0 1 7\n1 2 9\n");
+  assert(exported(after, EDGE_LIST, 1, 1) == "1 2 9\n");
+  std::string afterJson = exported(after, JSON, 3, 1);
+  assert(afterJson.find("\"x\"") == std::string::npos && afterJson.find("\"z\"") != std::string::npos);
+
+  cout << "graph export tests passed\n";
+  return 0;
+}
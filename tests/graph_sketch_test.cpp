@@ -0,0 +1,162 @@
+/**
+ * File: graph_sketch_test.cpp
+ * Description: Checks ReachabilitySketch against hop counts found by breadth
+ *              first search and SimilaritySketch against Jaccard similarities
+ *              of the neighbour sets, on random graphs, against the standard
+ *              errors the sketches state for themselves.
+ *
+ *              make -C tests
+ */
+
+#include "../graph_sketch.h"
+#include <cassert>
+#include <cmath>
+#include <queue>
+#include <set>
+
+using namespace GraphNameSpace;
+
+// hops from v to every vertex, -1 where there is no path
+std::vector<int> hopsFrom(const Graph<int>& graph, int v)
+{
+  std::vector<int> hops(graph.vertexCount(), -1);
+  std::queue<int> frontier;
+  hops[v] = 0;
+  frontier.push(v);
+  while(!frontier.empty())
+  {
+    int u = frontier.front();
+    frontier.pop();
+    graph.forEachNeighbor(u, [&](int connIndex, int)
+    {
+      if(hops[connIndex] == -1)
+      {
+        hops[connIndex] = hops[u] + 1;
+        frontier.push(connIndex);
+      }
+    });
+  }
+  return hops;
+}
+
+int main()
+{
+  srand(23);
+  const int N = 100, HOPS = 12;
+  for(int round = 0; round < 4; round++)
+  {
+    Graph<int> graph(round % 2 ? UNDIRECTED : DIRECTED, UNWEIGHTED);
+    for(int i = 0; i < N; i++)
+      graph.insertVertex(i);
+    int edges = 80 + 40 * round;
+    for(int k = 0; k < edges; k++)
+      graph.insertEdge(rand() % N, rand() % N);
+
+    std::vector<std::vector<int> > exact(N, std::vector<int>(HOPS + 1, 0));
+    int diameter = 0;
+    for(int v = 0; v < N; v++)
+    {
+      std::vector<int> hops = hopsFrom(graph, v);
+      for(int u = 0; u < N; u++)
+      {
+        for(int h = std::max(hops[u], 0); hops[u] != -1 && h <= HOPS; h++)
+          exact[v][h]++;
+        diameter = std::max(diameter, hops[u]);
+      }
+    }
+
+    // every counter shares the hash, so one seed gives much the same error
+    // to every large set; the stated error is over seeds
+    double wanted[2] = {0.2, 0.05};
+    for(int accuracy = 0; accuracy < 2; accuracy++)
+    {
+      double squares = 0, error = 0;
+      int samples = 0;
+      for(unsigned long long seed = 0; seed < 30; seed++)
+      {
+        ReachabilitySketch sketch(graph, HOPS, wanted[accuracy], 1, seed);
+        error = sketch.relativeError();
+        assert(error <= wanted[accuracy] && sketch.maxHops() == HOPS);
+        assert(sketch.hopsToConverge() <= std::min(diameter, HOPS));
+        if(seed == 0)
+        {
+          ReachabilitySketch parallel(graph, HOPS, wanted[accuracy], 4, seed);
+          for(int v = 0; v < N; v++)
+            assert(sketch.reachableWithin(v, HOPS) == parallel.reachableWithin(v, HOPS));
+        }
+        for(int h = 0; h <= HOPS; h++)
+        {
+          double pairs = 0;
+          for(int v = 0; v < N; v++)
+          {
+            double estimate = sketch.reachableWithin(v, h);
+            // the vertex always reaches itself
+            assert(estimate >= 1);
+            double relative = (estimate - exact[v][h]) / exact[v][h];
+            squares += relative * relative;
+            samples++;
+            pairs += estimate;
+          }
+          assert(std::fabs(sketch.pairsWithin(h) - pairs) <= 1e-6 * pairs);
+        }
+        assert(sketch.reachableWithin(0, HOPS + 5) == sketch.reachableWithin(0, HOPS));
+        assert(sketch.reachableWithin(-1, 1) == 0 && sketch.reachableWithin(N, 1) == 0 && sketch.reachableWithin(0, -1) == 0);
+      }
+      // single estimates of a few vertices can be far off when two of them
+      // share a register, so only the root mean square is held to the bound
+      assert(std::sqrt(squares / samples) <= error);
+    }
+  }
+
+  // neighbour sets of known overlap
+  for(int round = 0; round < 3; round++)
+  {
+    Graph<int> graph(DIRECTED, UNWEIGHTED);
+    for(int i = 0; i < N; i++)
+      graph.insertVertex(i);
+    const int SETS = 20;
+    std::vector<std::set<int> > neighbours(SETS);
+    for(int v = 0; v < SETS; v++)
+    {
+      int density = 1 + rand() % 9;
+      for(int u = SETS; u < N; u++)
+        if(rand() % 10 < density)
+        {
+          graph.insertEdge(v, u);
+          neighbours[v].insert(u);
+        }
+    }
+
+    double wanted = 0.04;
+    SimilaritySketch sketch(graph, wanted, 3, round);
+    SimilaritySketch serial(graph, wanted, 1, round);
+    assert(sketch.signatureSize() >= 0.25 / (wanted * wanted));
+    double squares = 0, worst = 0;
+    int samples = 0;
+    for(int a = 0; a < SETS; a++)
+      for(int b = 0; b < SETS; b++)
+      {
+        int shared = 0;
+        for(std::set<int>::iterator it = neighbours[a].begin(); it != neighbours[a].end(); ++it)
+          shared += neighbours[b].count(*it);
+        double exact = static_cast<double>(shared) / (neighbours[a].size() + neighbours[b].size() - shared);
+        double estimate = sketch.jaccard(a, b);
+        assert(estimate == serial.jaccard(a, b) && estimate == sketch.jaccard(b, a));
+        if(a == b)
+        {
+          assert(estimate == 1);
+          continue;
+        }
+        squares += (estimate - exact) * (estimate - exact);
+        worst = std::max(worst, std::fabs(estimate - exact));
+        samples++;
+      }
+    assert(std::sqrt(squares / samples) <= wanted && worst <= 4 * wanted);
+    // vertices without neighbours and positions out of range
+    assert(sketch.jaccard(0, SETS) == 0 && sketch.jaccard(SETS, SETS + 1) == 0);
+    assert(sketch.jaccard(-1, 0) == 0 && sketch.jaccard(0, N) == 0);
+  }
+
+  cout << "graph sketch tests passed\n";
+  return 0;
+}
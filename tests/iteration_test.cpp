@@ -0,0 +1,144 @@
+/**
+ * File: iteration_test.cpp
+ * Description: Checks neighbors, neighborsAt, forEachVertex, forEachNeighbor
+ *              and forEachEdge against adjacency kept beside the graph while
+ *              vertices and edges are inserted and deleted at random, so
+ *              deletions close gaps and renumber positions underneath them.
+ *
+ *              make -C tests
+ */
+
+#include "../graph.h"
+#include <cassert>
+#include <map>
+#include <set>
+
+using namespace GraphNameSpace;
+
+typedef std::multiset<std::pair<std::string, int> > Entries;
+
+void check(const Graph<std::string>& graph, const std::map<std::string, Entries>& adjacency)
+{
+  assert(graph.vertexCount() == static_cast<int>(adjacency.size()));
+  int visited = 0;
+  graph.forEachVertex([&](int vertexIndex, const std::string& info)
+  {
+    assert(vertexIndex == visited++);
+    assert(adjacency.count(info) == 1 && graph.findVertex(info) == vertexIndex);
+    assert(graph.infoAt(vertexIndex) == info);
+  });
+  assert(visited == graph.vertexCount());
+
+  long long entries = 0;
+  for(std::map<std::string, Entries>::const_iterator it = adjacency.begin(); it != adjacency.end(); ++it)
+  {
+    int vertexIndex = graph.findVertex(it->first);
+    Entries byRange, byPosition, byCallback;
+    AdjacencyRange<std::string> range = graph.neighbors(it->first);
+    for(AdjacencyRange<std::string>::iterator e = range.begin(); e != range.end(); ++e)
+      byRange.insert(std::make_pair(graph.infoAt(e->connIndex), e->edgeWeight));
+    range = graph.neighbors(graph.handleOf(it->first));
+    for(AdjacencyRange<std::string>::iterator e = range.begin(); e != range.end(); ++e)
+      byPosition.insert(std::make_pair(graph.infoAt(e->connIndex), e->edgeWeight));
+    graph.forEachNeighbor(vertexIndex, [&](int connIndex, int edgeWeight)
+    {
+      byCallback.insert(std::make_pair(graph.infoAt(connIndex), edgeWeight));
+    });
+    assert(byRange == it->second && byPosition == it->second && byCallback == it->second);
+    assert(graph.neighborsAt(vertexIndex).size() == static_cast<int>(it->second.size()));
+    entries += it->second.size();
+  }
+
+  long long edges = 0;
+  graph.forEachEdge([&](int fromIndex, int toIndex, int edgeWeight)
+  {
+    assert(adjacency.find(graph.infoAt(fromIndex))->second.count(std::make_pair(graph.infoAt(toIndex), edgeWeight)) > 0);
+    edges++;
+  });
+  assert(edges == entries);
+}
+
+int main()
+{
+  srand(5);
+  for(int round = 0; round < 6; round++)
+  {
+    bool undirected = round % 2 == 0;
+    Graph<std::string> graph(undirected ? UNDIRECTED : DIRECTED, WEIGHTED);
+    std::map<std::string, Entries> adjacency;
+    std::map<std::pair<std::string, std::string>, int> weightOf; // at most one edge per pair
+    for(int step = 0; step < 2000; step++)
+    {
+      std::string a = "v" + std::to_string(rand() % 30), b = "v" + std::to_string(rand() % 30);
+      if(undirected && b < a)
+        std::swap(a, b);
+      std::pair<std::string, std::string> pair(a, b);
+      int weight = rand() % 4;
+      int action = rand() % 8;
+      if(action < 2)
+      {
+        if(!adjacency.count(a))
+        {
+          graph.insertVertex(a);
+          adjacency[a];
+        }
+      }
+      else if(action < 3)
+      {
+        if(adjacency.erase(a))
+        {
+          graph.deleteVertex(a);
+          for(std::map<std::pair<std::string, std::string>, int>::iterator it = weightOf.begin(); it != weightOf.end(); )
+          {
+            if(it->first.first == a || it->first.second == a)
+              weightOf.erase(it++);
+            else
+              ++it;
+          }
+          for(std::map<std::string, Entries>::iterator it = adjacency.begin(); it != adjacency.end(); ++it)
+          {
+            for(Entries::iterator e = it->second.begin(); e != it->second.end(); )
+            {
+              if(e->first == a)
+                it->second.erase(e++);
+              else
+                ++e;
+            }
+          }
+        }
+      }
+      else if(action < 6)
+      {
+        if(adjacency.count(a) && adjacency.count(b) && !weightOf.count(pair) &&
+           adjacency[a].size() < 40 && adjacency[b].size() < 40)
+        {
+          graph.insertEdge(a, b, weight);
+          weightOf[pair] = weight;
+          adjacency[a].insert(std::make_pair(b, weight));
+          if(undirected)
+            adjacency[b].insert(std::make_pair(a, weight));
+        }
+      }
+      else if(weightOf.count(pair))
+      {
+        // an undirected self loop is stored twice and both entries go
+        int stored = weightOf[pair];
+        graph.deleteEdge(a, b);
+        weightOf.erase(pair);
+        adjacency[a].erase(adjacency[a].find(std::make_pair(b, stored)));
+        if(undirected)
+          adjacency[b].erase(adjacency[b].find(std::make_pair(a, stored)));
+      }
+      if(step % 10 == 0)
+        check(graph, adjacency);
+    }
+    check(graph, adjacency);
+  }
+
+  // a missing vertex has an empty range
+  Graph<std::string> empty(DIRECTED, UNWEIGHTED);
+  assert(empty.neighbors("none").empty());
+
+  cout << "iteration tests passed\n";
+  return 0;
+}
@@ -0,0 +1,135 @@
+/**
+ * File: query_server_test.cpp
+ * Description: Drives a QueryServer through QueryClient on a temporary
+ *              socket: pipelined breadth first searches answered in
+ *              batches, a client that stops reading its answers, and a
+ *              request line longer than MAX_LINE.
+ *
+ *              make -C tests
+ */
+
+#include "../graph_server.h"
+#include <atomic>
+#include <cassert>
+#include <thread>
+
+using namespace GraphNameSpace;
+
+std::vector<int> distancesFrom(const Graph<int>& graph, int source)
+{
+  std::vector<int> distance(graph.vertexCount(), -1), queue(1, source);
+  distance[source] = 0;
+  for(size_t head = 0; head < queue.size(); head++)
+    graph.forEachNeighbor(queue[head], [&](int to, int) {
+      if(distance[to] == -1)
+      {
+        distance[to] = distance[queue[head]] + 1;
+        queue.push_back(to);
+      }
+    });
+  return distance;
+}
+
+int main()
+{
+  // a 9 by 9 grid with one edge of a large weight, vertex 81 is isolated
+  Graph<int> graph(UNDIRECTED, WEIGHTED);
+  for(int i = 0; i < 82; i++)
+    graph.insertVertex(i);
+  for(int row = 0; row < 9; row++)
+    for(int column = 0; column < 9; column++)
+    {
+      int vertex = 9 * row + column;
+      if(column < 8)
+        graph.insertEdge(vertex, vertex + 1, vertex == 0 ? 123456789 : 1);
+      if(row < 8)
+        graph.insertEdge(vertex, vertex + 9, 1);
+    }
+
+  std::ostringstream path;
+  path << "/tmp/query_server_test_" << ::getpid() << ".sock";
+  QueryServer<int> server(graph, path.str(), 4096, 4);
+  assert(server.start());
+
+  // pipelined searches come back in order and are answered in batches
+  QueryClient client;
+  assert(client.connect(path.str()));
+  std::string requests;
+  std::vector<std::string> expected;
+  for(int source = 0; source < 82; source += 7)
+  {
+    std::vector<int> distance = distancesFrom(graph, source);
+    for(int target = 0; target < 82; target++)
+    {
+      std::ostringstream request;
+      request << "BFS " << source << ' ' << target;
+      requests += request.str() + '\n';
+      std::ostringstream answer;
+      answer << distance[target];
+      expected.push_back(answer.str());
+    }
+  }
+  requests += "BFS 0 500\nADJ 0\nNOPE 1 2\nADJ 0 1\nADJ 0 2\nWEIGHT 1 0\nWEIGHT 0 80";
+  expected.push_back("ERR no such vertex");
+  expected.push_back("ERR expected two vertices");
+  expected.push_back("ERR unknown command");
+  expected.push_back("1");
+  expected.push_back("0");
+  expected.push_back("123456789");
+  expected.push_back("-1");
+  assert(client.send(requests));
+  for(size_t i = 0; i < expected.size(); i++)
+    assert(client.receive() == expected[i]);
+  ServerMetrics counters = server.metrics();
+  assert(counters.requests == static_cast<long long>(expected.size()));
+  assert(counters.largestBatch > 1 && counters.batches < counters.requests && counters.queueDepth == 0);
+  assert(client.query("STATS").compare(0, 9, "requests=") == 0);
+
+  // a client that sends without reading stops being read once its answers
+  // pile up, and gets every one of them once it reads again
+  const int CHUNKS = 500, LINES = 1000;
+  std::string chunk;
+  for(int i = 0; i < LINES; i++)
+    chunk += "WEIGHT 0 1\n";
+  chunk.erase(chunk.size() - 1);
+  QueryClient slow;
+  assert(slow.connect(path.str()));
+  long long before = server.metrics().requests;
+  std::atomic<int> sent(0);
+  std::thread sender([&]() {
+    for(int i = 0; i < CHUNKS && slow.send(chunk); i++)
+      sent++;
+  });
+  int seen = -1;
+  while(seen != sent.load())
+  {
+    seen = sent.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  }
+  assert(seen < CHUNKS);
+  long long held = server.metrics().requests - before;
+  assert(held < static_cast<long long>(CHUNKS) * LINES);
+  assert(client.query("BFS 0 80") == "16");
+  for(int i = 0; i < CHUNKS * LINES; i++)
+    assert(slow.receive() == "123456789");
+  sender.join();
+  assert(sent.load() == CHUNKS);
+
+  // a line longer than MAX_LINE closes the connection, the longest
+  // accepted line is still answered
+  QueryClient flooding;
+  assert(flooding.connect(path.str()));
+  assert(flooding.query("ADJ 0 1" + std::string((1 << 16) - 8, ' ')) == "1");
+  flooding.send(std::string((1 << 16) + 100, 'x'));
+  assert(flooding.receive().empty());
+  assert(client.query("ADJ 0 9") == "1");
+
+  client.disconnect();
+  slow.disconnect();
+  flooding.disconnect();
+  server.stop();
+  assert(::access(path.str().c_str(), F_OK) == -1);
+
+  cout << "query server tests passed\n";
+  return 0;
+}
@@ -0,0 +1,189 @@
+/**
+ * File: shard_runtime_test.cpp
+ * Description: Checks the sharded breadth first search and PageRank against
+ *              the same algorithms run on the whole graph in one process,
+ *              for every partition method, and checks that readShard
+ *              rejects damaged shards instead of handing the runtime
+ *              indices it would use out of bounds.
+ *
+ *              make -C tests
+ */
+
+#include "../shard_runtime.h"
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <sstream>
+
+using namespace GraphNameSpace;
+
+// overwrites the little endian 32 bit integer at a byte offset of a shard
+void patchInt32(std::string& bytes, size_t at, int value)
+{
+  for(int i = 0; i < 4; i++)
+    bytes[at + i] = static_cast<char>((static_cast<unsigned>(value) >> (8 * i)) & 0xff);
+}
+
+bool readsBack(const std::string& bytes)
+{
+  std::stringstream in(bytes);
+  GraphShard<int> shard;
+  bool read = readShard(in, shard);
+  assert(read || (shard.globalIndex.empty() && shard.offset.empty() && shard.target.empty()));
+  return read;
+}
+
+int main()
+{
+  std::mt19937 random(5);
+  PartitionMethod methods[3] = {LDG, FENNEL, MULTILEVEL};
+  for(int round = 0; round < 40; round++)
+  {
+    Graph<int> graph(UNWEIGHTED, round % 2 ? UNDIRECTED : DIRECTED);
+    int n = 1 + random() % 100;
+    for(int i = 0; i < n; i++)
+      graph.insertVertex(i);
+    for(int k = 0; k < 3 * n; k++)
+    {
+      int a = random() % n, b = (a + 1 + random() % 5) % n;
+      if(graph.neighborsAt(a).size() < 90 && graph.neighborsAt(b).size() < 90)
+        graph.insertEdge(a, b);
+    }
+
+    // single process references
+    std::vector<int> distance(n, -1), queue(1, 0);
+    distance[0] = 0;
+    for(size_t head = 0; head < queue.size(); head++)
+      graph.forEachNeighbor(queue[head], [&](int to, int) {
+        if(distance[to] == -1)
+        {
+          distance[to] = distance[queue[head]] + 1;
+          queue.push_back(to);
+        }
+      });
+    std::vector<double> rank(n, 1.0 / n);
+    for(int step = 0; step < 30; step++)
+    {
+      std::vector<double> incoming(n, 0);
+      double dangling = 0;
+      for(int u = 0; u < n; u++)
+      {
+        int degree = graph.neighborsAt(u).size();
+        if(degree == 0)
+          dangling += rank[u];
+        else
+          graph.forEachNeighbor(u, [&](int to, int) { incoming[to] += rank[u] / degree; });
+      }
+      for(int u = 0; u < n; u++)
+        rank[u] = 0.15 / n + 0.85 * (incoming[u] + dangling / n);
+    }
+
+    for(int m = 0; m < 3; m++)
+    {
+      int shardCount = 1 + random() % 5;
+      Partition partition = partitionGraph(graph, shardCount, methods[m], 1.2);
+      std::vector<GraphShard<int> > shards = buildShards(graph, partition);
+
+      // every shard survives a round trip through its serialized form
+      for(size_t s = 0; s < shards.size(); s++)
+      {
+        std::stringstream buffer;
+        writeShard(shards[s], buffer);
+        GraphShard<int> read;
+        assert(readShard(buffer, read));
+        assert(read.globalIndex == shards[s].globalIndex && read.ghostOwner == shards[s].ghostOwner);
+        assert(read.offset == shards[s].offset && read.target == shards[s].target && read.info == shards[s].info);
+        shards[s] = read;
+      }
+
+      std::vector<std::vector<int> > distances(shardCount);
+      std::vector<std::vector<double> > ranks(shardCount);
+      runShardsLocally(shards, [&](const GraphShard<int>& shard, ShardTransport& transport) {
+        distances[shard.shardId] = shardBreadthFirst(shard, transport, 0);
+        ranks[shard.shardId] = shardPageRank(shard, transport, 30);
+      });
+      assert(gatherOwned(shards, distances, n, -2) == distance);
+      std::vector<double> gathered = gatherOwned(shards, ranks, n, 0.0);
+      for(int u = 0; u < n; u++)
+        assert(std::fabs(gathered[u] - rank[u]) < 1e-9);
+    }
+  }
+
+  // damaged shards: header at 8, then shardId, shardCount, ownedCount,
+  // flags, locals and edges, then the global indices from byte 32
+  Graph<int> path(DIRECTED, UNWEIGHTED);
+  for(int i = 0; i < 10; i++)
+    path.insertVertex(i);
+  for(int i = 0; i < 9; i++)
+    path.insertEdge(i, i + 1);
+  std::vector<GraphShard<int> > pathShards = buildShards(path, partitionGraph(path, 2));
+  const GraphShard<int>& shard = pathShards[0];
+  std::stringstream buffer;
+  writeShard(shard, buffer);
+  const std::string good = buffer.str();
+  assert(readsBack(good));
+  int locals = shard.globalIndex.size(), owned = shard.ownedCount;
+  assert(locals > owned && shard.target.size() > 0);
+  size_t ghostsAt = 32 + 4 * locals, offsetsAt = ghostsAt + 4 * (locals - owned);
+  size_t infoAt = offsetsAt + 4 * (owned + 1) + 8 * shard.target.size();
+
+  std::streambuf* console = cerr.rdbuf();
+  std::stringstream errors;
+  cerr.rdbuf(errors.rdbuf());
+  std::string bad = good;
+  patchInt32(bad, 12, 0);                      // no shards
+  assert(!readsBack(bad));
+  bad = good;
+  patchInt32(bad, 8, 2);                       // shard id past the count
+  assert(!readsBack(bad));
+  bad = good;
+  patchInt32(bad, 8, -1);
+  assert(!readsBack(bad));
+  bad = good;
+  patchInt32(bad, 32, shard.globalIndex[1]);   // duplicate global index
+  assert(!readsBack(bad));
+  bad = good;
+  patchInt32(bad, ghostsAt, 2);                // ghost owner past the count
+  assert(!readsBack(bad));
+  bad = good;
+  patchInt32(bad, ghostsAt, 0);                // ghost owned by this shard
+  assert(!readsBack(bad));
+  bad = good;
+  patchInt32(bad, offsetsAt + 4, -1);          // decreasing offsets
+  assert(!readsBack(bad));
+  bad = good;
+  patchInt32(bad, offsetsAt + 4 * owned, 0);   // last offset isn't the edge count
+  assert(!readsBack(bad));
+  bad = good;
+  patchInt32(bad, 28, 1 << 30);                // edge count the stream doesn't hold
+  assert(!readsBack(bad));
+  bad = good;
+  patchInt32(bad, infoAt, 1 << 30);            // info length the stream doesn't hold
+  assert(!readsBack(bad));
+  for(size_t length = 0; length < good.size(); length++)
+    assert(!readsBack(good.substr(0, length)));
+
+  // any single flipped byte is either read back or rejected, never trusted
+  // with an index out of range
+  for(size_t at = 8; at < good.size(); at++)
+    for(int bit = 0; bit < 8; bit++)
+    {
+      bad = good;
+      bad[at] ^= static_cast<char>(1 << bit);
+      std::stringstream in(bad);
+      GraphShard<int> read;
+      if(!readShard(in, read))
+        continue;
+      assert(read.shardId >= 0 && read.shardId < read.shardCount);
+      assert(read.offset.size() == static_cast<size_t>(read.ownedCount) + 1);
+      assert(read.offset.back() == static_cast<int>(read.target.size()));
+      for(size_t e = 0; e < read.target.size(); e++)
+        assert(read.target[e] >= 0 && read.target[e] < static_cast<int>(read.globalIndex.size()));
+      for(size_t g = 0; g < read.ghostOwner.size(); g++)
+        assert(read.ghostOwner[g] >= 0 && read.ghostOwner[g] < read.shardCount);
+    }
+  cerr.rdbuf(console);
+
+  cout << "shard runtime tests passed\n";
+  return 0;
+}
@@ -0,0 +1,55 @@
+/**
+ * File: spanning_forest_test.cpp
+ * Description: Regression test for the parallel minimum spanning forest.
+ *              Boruvka's edge list shrinks below the thread count after the
+ *              first round, so parallelFor runs fewer chunks than there are
+ *              per-thread slots; stale slots used to be read back and the
+ *              loop never ended.
+ *
+ *              g++ -std=c++14 -pthread -I.. spanning_forest_test.cpp && ./a.out
+ */
+
+#include "../temporal_graph.h"
+#include <cassert>
+
+using namespace GraphNameSpace;
+
+int main()
+{
+  // two stars of 4200 leaves joined by one bridge, too big for Graph itself
+  const int LEAVES = 4200;
+  TemporalGraph<int> graph(UNDIRECTED, WEIGHTED);
+  for(int v = 0; v < 2 * (LEAVES + 1); v++)
+    graph.insertVertex(v, 0);
+  for(int star = 0; star < 2; star++)
+  {
+    int center = star * (LEAVES + 1);
+    for(int leaf = 1; leaf <= LEAVES; leaf++)
+      graph.insertEdge(center, center + leaf, 3 + star, 0);
+  }
+  graph.insertEdge(0, LEAVES + 1, 1000, 0);
+  TemporalSnapshot<int> snapshot = graph.snapshot(0);
+
+  SpanningForest expected = kruskalSpanningForest(snapshot, 1);
+  assert(expected.edges.size() == 2 * LEAVES + 1);
+  assert(expected.totalWeight == 3 * LEAVES + 4 * LEAVES + 1000);
+
+  for(int threads = 1; threads <= 8; threads++)
+  {
+    SpanningForest forest = boruvkaSpanningForest(snapshot, threads);
+    assert(forest.edges.size() == expected.edges.size());
+    assert(forest.totalWeight == expected.totalWeight);
+  }
+
+  // an edge list shorter than the thread count from the start
+  Graph<int> small(UNDIRECTED, WEIGHTED);
+  for(int v = 0; v < 4; v++)
+    small.insertVertex(v);
+  small.insertEdge(0, 1, 2);
+  small.insertEdge(2, 3, 5);
+  for(int threads = 1; threads <= 8; threads++)
+    assert(small.minimumSpanningForest(BORUVKA, threads).totalWeight == 7);
+
+  cout << "spanning forest tests passed\n";
+  return 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * File: temporal_graph_test.cpp
+ * Description: Tests for the versioned graph: snapshots keep seeing their
+ *              time across later deletions, garbage collection and writes
+ *              to the blocks they share, on one thread and while another
+ *              thread keeps writing.
+ *
+ *              make -C tests (and with SANITIZE=-fsanitize=thread)
+ */
+
+#include "../temporal_graph.h"
+#include <cassert>
+#include <string>
+#include <thread>
+#include <atomic>
+
+using namespace GraphNameSpace;
+
+// sum over the visible edges, the same for as long as the snapshot lives
+template<class GraphType>
+long long checksum(const GraphType& graph)
+{
+  long long sum = 0;
+  graph.forEachEdge([&](int from, int to, int edgeWeight)
+  {
+    sum += (from + 1) * 131LL + (to + 1) * 7LL + edgeWeight;
+  });
+  return sum;
+}
+
+int main()
+{
+  // snapshot isolation across deleteEdge and deleteVertex
+  TemporalGraph<std::string> graph(UNDIRECTED, WEIGHTED);
+  graph.insertVertex("a", 1);
+  graph.insertVertex("b", 1);
+  graph.insertVertex("c", 1);
+  graph.insertEdge("a", "b", 5, 2);
+  graph.insertEdge("b", "c", 6, 2);
+  TemporalSnapshot<std::string> before = graph.snapshot(2);
+  graph.deleteEdge("a", "b", 3);
+  graph.deleteVertex("c", 4);
+  assert(before.isAdjacentTo("a", "b") && before.isAdjacentTo("b", "a"));
+  assert(before.edgeWeight("b", "c") == 6);
+  assert(!graph.isAdjacentTo("a", "b", 3) && graph.isAdjacentTo("a", "b", 2));
+  assert(graph.snapshot(4).findVertex("c") == -1 && before.findVertex("c") == 2);
+  assert(graph.snapshot(3).edgeWeight("b", "c") == 6);
+  assert(before.materialize().edgeCount() == 2);
+
+  // garbage collection while a snapshot is alive
+  graph.insertVertex("c", 5);
+  graph.insertEdge("a", "c", 7, 5);
+  TemporalSnapshot<std::string> held = graph.snapshot(2);
+  long long heldSum = checksum(held);
+  assert(graph.collectGarbage(5) == 4); // a-b and the old b-c, both ends
+  assert(checksum(held) == heldSum && held.isAdjacentTo("b", "c"));
+  TemporalSnapshot<std::string> after = graph.snapshot(5);
+  assert(after.findVertex("c") == 3 && !after.containsVertex(2));
+  assert(after.isAdjacentTo("a", "c") && !after.isAdjacentTo("a", "b"));
+  assert(graph.horizon() == 5 && !graph.isAdjacentTo("a", "c", 4));
+
+  // copy on write of a block a snapshot shares: the writes land in the
+  // same block of "hub" the snapshot still reads
+  TemporalGraph<int> star(DIRECTED, WEIGHTED);
+  for(int v = 0; v < 40; v++)
+    star.insertVertex(v, 0);
+  for(int v = 1; v < 10; v++)
+    star.insertEdge(0, v, v, 1);
+  TemporalSnapshot<int> shared = star.snapshot(1);
+  long long sharedSum = checksum(shared);
+  for(int v = 10; v < 40; v++)
+    star.insertEdge(0, v, v, 2);
+  for(int v = 1; v < 10; v += 2)
+    star.deleteEdge(0, v, 3);
+  star.collectGarbage(3);
+  assert(checksum(shared) == sharedSum);
+  int seen = 0;
+  shared.forEachNeighbor(0, [&](int, int) { seen++; });
+  assert(seen == 9);
+  seen = 0;
+  star.snapshot(3).forEachNeighbor(0, [&](int, int) { seen++; });
+  assert(seen == 9 - 5 + 30);
+
+  // many vertices, so the vertex table and key index grow past one chunk
+  TemporalGraph<int> big(UNDIRECTED, UNWEIGHTED);
+  for(int v = 0; v < 5000; v++)
+    big.insertVertex(v, 0);
+  TemporalSnapshot<int> early = big.snapshot(0);
+  for(int v = 0; v < 5000; v += 2)
+    big.deleteVertex(v, 1);
+  for(int v = 0; v < 5000; v += 2)
+    big.insertVertex(v, 2);
+  big.collectGarbage(2);
+  TemporalSnapshot<int> late = big.snapshot(2);
+  for(int v = 0; v < 5000; v++)
+  {
+    assert(early.findVertex(v) == v);
+    assert(late.findVertex(v) == (v % 2 ? v : 5000 + v / 2));
+  }
+  assert(late.positionCount() == 7500 && late.vertexCount() == 5000 && !late.containsVertex(0) && late.containsVertex(5000));
+
+  // snapshots taken and read while another thread writes and collects
+  TemporalGraph<int> live(DIRECTED, WEIGHTED);
+  for(int v = 0; v < 50; v++)
+    live.insertVertex(v, 0);
+  std::atomic<bool> writing(true);
+  std::thread writer([&]()
+  {
+    for(Timestamp t = 1; t < 20000; t++)
+    {
+      live.insertEdge(static_cast<int>(t % 50), static_cast<int>(t * 7 % 50), static_cast<int>(t), t);
+      if(t % 3 == 0)
+        live.deleteEdge(static_cast<int>(t % 50), static_cast<int>(t * 7 % 50), t);
+      if(t % 500 == 0)
+        live.collectGarbage(t - 100);
+    }
+    writing = false;
+  });
+  // run under -fsanitize=thread to check the copy-on-write ordering too
+  while(writing)
+  {
+    TemporalSnapshot<int> snapshot = live.snapshot(live.latest());
+    long long first = checksum(snapshot);
+    assert(checksum(snapshot) == first);
+  }
+  writer.join();
+
+  cout << "temporal graph tests passed\n";
+  return 0;
+}
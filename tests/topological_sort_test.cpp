@@ -0,0 +1,182 @@
+/**
+ * File: topological_sort_test.cpp
+ * Description: Checks topologicalSort, its cycle report, and criticalPaths,
+ *              longestPathsFrom and shortestPathsFrom against path lengths
+ *              recomputed by memoized recursion over the predecessors, on
+ *              random DAGs with negative weights and on graphs with cycles.
+ *
+ *              make -C tests
+ */
+
+#include "../graph.h"
+#include <algorithm>
+#include <cassert>
+#include <random>
+
+using namespace GraphNameSpace;
+
+struct Reference
+{
+  std::vector<std::vector<std::pair<int, int> > > incoming; // (from, weight) per vertex
+  std::vector<long long> memo;
+  std::vector<char> done;
+  int source; // -1 for paths from any vertex without predecessors
+  bool longest;
+
+  // best length of a path ending at v, UNREACHABLE if there is none
+  long long best(int v)
+  {
+    if(done[v])
+      return memo[v];
+    long long length = UNREACHABLE;
+    if(v == source || (source == -1 && incoming[v].empty()))
+      length = 0;
+    else
+    {
+      for(size_t i = 0; i < incoming[v].size(); i++)
+      {
+        long long before = best(incoming[v][i].first);
+        if(before == UNREACHABLE)
+          continue;
+        long long candidate = before + incoming[v][i].second;
+        if(length == UNREACHABLE || (longest ? candidate > length : candidate < length))
+          length = candidate;
+      }
+    }
+    done[v] = 1;
+    return memo[v] = length;
+  }
+};
+
+template<class Type>
+void checkPaths(const Graph<Type>& graph, const DagPaths& paths, int source, bool longest)
+{
+  int n = graph.vertexCount();
+  bool weighted = graph.weigh == WEIGHTED;
+  Reference reference;
+  reference.incoming.resize(n);
+  graph.forEachEdge([&](int from, int to, int edgeWeight)
+  {
+    reference.incoming[to].push_back(std::make_pair(from, weighted ? edgeWeight : 1));
+  });
+  reference.memo.assign(n, 0);
+  reference.done.assign(n, 0);
+  reference.source = source;
+  reference.longest = longest;
+
+  assert(paths.acyclic);
+  for(int v = 0; v < n; v++)
+  {
+    assert(paths.distance[v] == reference.best(v));
+    std::vector<int> path = tracePath(paths, v);
+    if(paths.distance[v] == UNREACHABLE)
+    {
+      assert(path.empty());
+      continue;
+    }
+    // the predecessors spell out a path of exactly that length
+    assert(path.back() == v);
+    assert(source == -1 ? reference.incoming[path.front()].empty() : path.front() == source);
+    long long length = 0;
+    for(size_t i = 1; i < path.size(); i++)
+    {
+      long long step = UNREACHABLE;
+      graph.forEachNeighbor(path[i - 1], [&](int connIndex, int edgeWeight)
+      {
+        long long w = weighted ? edgeWeight : 1;
+        if(connIndex == path[i] && (step == UNREACHABLE || (longest ? w > step : w < step)))
+          step = w;
+      });
+      assert(step != UNREACHABLE);
+      length += step;
+    }
+    assert(length == paths.distance[v]);
+  }
+}
+
+int main()
+{
+  std::mt19937 random(2);
+  for(int round = 0; round < 300; round++)
+  {
+    bool weighted = round % 4 != 3;
+    Graph<int> graph(weighted ? WEIGHTED : UNWEIGHTED, DIRECTED);
+    int n = 1 + random() % 60;
+    for(int i = 0; i < n; i++)
+      graph.insertVertex(i);
+    // edges follow a hidden order, except in the rounds meant to have cycles
+    std::vector<int> rank(n);
+    for(int i = 0; i < n; i++)
+      rank[i] = i;
+    std::shuffle(rank.begin(), rank.end(), random);
+    bool cyclic = round % 3 == 0;
+    int edges = random() % (3 * n);
+    for(int k = 0; k < edges; k++)
+    {
+      int a = random() % n, b = random() % n;
+      if(!cyclic && rank[a] >= rank[b])
+        std::swap(a, b);
+      if((cyclic || a != b) && graph.neighborsAt(a).size() < 90)
+        graph.insertEdge(a, b, static_cast<int>(random() % 9) - 3);
+    }
+
+    TopologicalOrder sorted = graph.topologicalSort(1);
+    TopologicalOrder parallel = graph.topologicalSort(4);
+    assert(sorted.order == parallel.order && sorted.level == parallel.level && sorted.acyclic == parallel.acyclic);
+    for(size_t i = 0; i < sorted.order.size(); i++)
+      assert(sorted.position[sorted.order[i]] == static_cast<int>(i));
+    graph.forEachEdge([&](int from, int to, int)
+    {
+      // an edge out of a vertex left behind a cycle leads to one left behind too
+      if(sorted.position[from] == -1)
+        assert(sorted.position[to] == -1);
+      else if(sorted.position[to] != -1)
+        assert(sorted.position[from] < sorted.position[to] && sorted.level[from] < sorted.level[to]);
+    });
+
+    if(sorted.acyclic)
+    {
+      assert(sorted.cycle.empty());
+      assert(static_cast<int>(sorted.order.size()) == n);
+      checkPaths(graph, graph.criticalPaths(3), -1, true);
+      int source = random() % n;
+      checkPaths(graph, graph.longestPathsFrom(source, 2), source, true);
+      checkPaths(graph, graph.shortestPathsFrom(graph.handleOf(source), 2), source, false);
+    }
+    else
+    {
+      // the reported cycle is a closed walk over edges of the graph
+      assert(cyclic && !sorted.cycle.empty() && static_cast<int>(sorted.order.size()) < n);
+      for(size_t i = 0; i < sorted.cycle.size(); i++)
+      {
+        int from = sorted.cycle[i], to = sorted.cycle[(i + 1) % sorted.cycle.size()];
+        bool found = false;
+        graph.forEachNeighbor(from, [&](int connIndex, int) { found = found || connIndex == to; });
+        assert(found && sorted.position[from] == -1);
+      }
+      std::vector<int> seen(sorted.cycle);
+      std::sort(seen.begin(), seen.end());
+      assert(std::unique(seen.begin(), seen.end()) == seen.end());
+      assert(!graph.criticalPaths().acyclic && !graph.longestPathsFrom(0).acyclic && !graph.shortestPathsFrom(0).acyclic);
+    }
+  }
+
+  // a three vertex diamond counted in edges
+  Graph<std::string> diamond(UNWEIGHTED, DIRECTED);
+  diamond.insertVertex("a");
+  diamond.insertVertex("b");
+  diamond.insertVertex("c");
+  diamond.insertEdge("a", "b");
+  diamond.insertEdge("b", "c");
+  diamond.insertEdge("a", "c");
+  DagPaths critical = diamond.criticalPaths();
+  assert(critical.distance[2] == 2 && tracePath(critical, 2) == std::vector<int>({0, 1, 2}));
+
+  // only directed graphs can be sorted
+  Graph<int> undirected(UNWEIGHTED, UNDIRECTED);
+  undirected.insertVertex(1);
+  assert(!undirected.topologicalSort().acyclic && undirected.topologicalSort().order.empty());
+
+  cout << "topological sort tests passed\n";
+  return 0;
+}
@@ -0,0 +1,118 @@
+/**
+ * File: vertex_handle_test.cpp
+ * Description: Tests for the vertex handles and the interned keys: handles
+ *              survive the deletion of other vertices, a handle of a
+ *              deleted vertex never names the vertex that reuses its slot,
+ *              and the keys follow insertions, deletions and copies.
+ *
+ *              make -C tests
+ */
+
+#include "../graph.h"
+#include <cassert>
+#include <string>
+#include <set>
+#include <cstdlib>
+
+using namespace GraphNameSpace;
+
+// every key collides, so lookups and deletions walk long probe runs
+struct CollidingHash
+{
+  size_t operator()(int) const { return 7; }
+};
+
+int main()
+{
+  Graph<std::string> graph(UNDIRECTED, WEIGHTED);
+  VertexHandle a = graph.insertVertex("a");
+  VertexHandle b = graph.insertVertex("b");
+  VertexHandle c = graph.insertVertex("c");
+  graph.insertEdge(a, b, 4);
+  graph.insertEdge(b, c, 5);
+
+  // positions move, handles don't
+  graph.deleteVertex(a);
+  assert(graph.positionOf(b) == 0 && graph.positionOf(c) == 1);
+  assert(graph.info(c) == "c");
+  assert(graph.edgeWeight(b, c) == 5);
+
+  // the slot of a is reused by d, the old handle stays dead
+  VertexHandle d = graph.insertVertex("d");
+  assert(d.id == a.id && d != a);
+  assert(graph.positionOf(a) == -1);
+  assert(graph.info(a) == "");
+  assert(graph.info(d) == "d");
+  graph.deleteVertex(a);
+  assert(graph.vertexCount() == 3 && graph.findVertex("d") == 2);
+  assert(!graph.isAdjacentTo(a, b));
+  assert(graph.handleOf("d") == d);
+  assert(graph.positionOf(NO_VERTEX) == -1);
+
+  // keys follow deletions and reinsertions
+  assert(graph.findVertex("a") == -1);
+  graph.deleteVertex(d);
+  VertexHandle again = graph.insertVertex("a");
+  assert(graph.handleOf("a") == again && graph.info(again) == "a");
+  assert(graph.positionOf(d) == -1);
+
+  // a copy keeps the handles and the keys
+  Graph<std::string> copy(graph);
+  assert(copy.info(again) == "a" && copy.info(c) == "c");
+  assert(copy.positionOf(d) == -1);
+  copy.deleteVertex(std::string("b"));
+  assert(copy.findVertex("b") == -1 && graph.findVertex("b") == 0);
+  graph = copy;
+  assert(graph.findVertex("b") == -1 && graph.handleOf("c") == c);
+
+  // many keys, to make the table grow and keep finding them
+  Graph<int> numbers(DIRECTED, UNWEIGHTED);
+  for(int round = 0; round < 20; round++)
+  {
+    for(int v = 0; v < MAX_VERTICES; v++)
+      numbers.insertVertex(round * 1000 + v);
+    for(int v = 0; v < MAX_VERTICES; v++)
+      assert(numbers.findVertex(round * 1000 + v) != -1);
+    for(int v = 0; v < MAX_VERTICES; v += 2)
+      numbers.deleteVertex(round * 1000 + v);
+    for(int v = 0; v < MAX_VERTICES; v++)
+      assert((numbers.findVertex(round * 1000 + v) == -1) == (v % 2 == 0));
+    for(int v = 1; v < MAX_VERTICES; v += 2)
+      numbers.deleteVertex(round * 1000 + v);
+    assert(numbers.vertexCount() == 0);
+  }
+
+  // a full graph refuses the insert instead of throwing out of it
+  Graph<int> full(DIRECTED, UNWEIGHTED);
+  for(int v = 0; v < MAX_VERTICES; v++)
+    full.insertVertex(v);
+  assert(full.insertVertex(MAX_VERTICES) == NO_VERTEX);
+  assert(full.vertexCount() == MAX_VERTICES && full.findVertex(MAX_VERTICES) == -1);
+
+  // random churn with colliding keys against a std::set
+  Graph<int, CollidingHash> colliding(UNDIRECTED, UNWEIGHTED);
+  std::set<int> present;
+  srand(7);
+  for(int step = 0; step < 20000; step++)
+  {
+    int key = rand() % 150;
+    if(present.count(key))
+    {
+      colliding.deleteVertex(key);
+      present.erase(key);
+    }
+    else if(static_cast<int>(present.size()) < MAX_VERTICES)
+    {
+      colliding.insertVertex(key);
+      present.insert(key);
+    }
+    int probe = rand() % 150;
+    assert((colliding.findVertex(probe) != -1) == (present.count(probe) == 1));
+    if(present.count(probe))
+      assert(colliding.info(colliding.handleOf(probe)) == probe);
+  }
+  assert(colliding.vertexCount() == static_cast<int>(present.size()));
+
+  cout << "vertex handle tests passed\n";
+  return 0;
+}
@@ -0,0 +1,174 @@
+/**
+ * File: walk_engine_test.cpp
+ * Description: Checks the WalkEngine distributions against their exact
+ *              probabilities: weighted steps, the stationary distribution of
+ *              uniform walks and the second order bias of node2vec walks.
+ *              Also checks that walks and samples only follow edges, stay
+ *              inside the buffer they are given, pad with -1 where there is
+ *              nothing to pick, and don't depend on the thread count.
+ *
+ *              make -C tests
+ */
+
+#include "../graph_sampling.h"
+#include <cassert>
+#include <cmath>
+
+using namespace GraphNameSpace;
+
+// the count of an event of probability p over n tries, within 5 standard deviations
+bool expected(long long count, long long n, double p)
+{
+  return std::fabs(count - n * p) <= 5 * std::sqrt(n * p * (1 - p)) + 1e-9;
+}
+
+int main()
+{
+  const int CANARY = 0x5eed;
+
+  // weighted steps are picked in proportion to the weight, never at 0 or below
+  Graph<int> star(DIRECTED, WEIGHTED);
+  for(int i = 0; i < 8; i++)
+    star.insertVertex(i);
+  int weights[6] = {1, 2, 3, 4, 0, -5};
+  for(int i = 0; i < 6; i++)
+    star.insertEdge(0, i + 1, weights[i]);
+  star.insertEdge(7, 1, 0);
+  star.insertEdge(7, 2, 0);
+  WalkEngine stars(star, 2);
+  const int SAMPLES = 200000;
+  std::vector<int> nodes(1, 0), out(SAMPLES + 1, CANARY);
+  stars.sampleNeighbors(nodes, SAMPLES, &out[0], 7, 4);
+  assert(out[SAMPLES] == CANARY);
+  std::vector<long long> picked(8, 0);
+  for(int s = 0; s < SAMPLES; s++)
+    picked[out[s]]++;
+  for(int i = 0; i < 4; i++)
+    assert(expected(picked[i + 1], SAMPLES, weights[i] / 10.0));
+  assert(picked[0] == 0 && picked[5] == 0 && picked[6] == 0 && picked[7] == 0);
+  // a vertex whose edges all weigh 0 picks uniformly
+  nodes[0] = 7;
+  stars.sampleNeighbors(nodes, SAMPLES, &out[0], 8, 4);
+  long long first = 0;
+  for(int s = 0; s < SAMPLES; s++)
+  {
+    assert(out[s] == 1 || out[s] == 2);
+    first += out[s] == 1;
+  }
+  assert(expected(first, SAMPLES, 0.5));
+
+  // rows of vertices with nothing to pick are -1, the buffer isn't overrun
+  std::vector<int> mixed = {0, 3, -1, 8, 1000, 7};
+  const int FANOUT = 5;
+  std::vector<int> rows(mixed.size() * FANOUT + 1, CANARY), again(rows);
+  stars.sampleNeighbors(mixed, FANOUT, &rows[0], 9, 1);
+  stars.sampleNeighbors(mixed, FANOUT, &again[0], 9, 3);
+  assert(rows == again && rows.back() == CANARY);
+  for(size_t r = 0; r < mixed.size(); r++)
+    for(int s = 0; s < FANOUT; s++)
+    {
+      int sample = rows[r * FANOUT + s];
+      if(r == 0 || r == 5)
+        assert(sample >= 1 && sample <= 4 - 2 * (r == 5) && star.isAdjacentTo(mixed[r], sample));
+      else
+        assert(sample == -1);
+    }
+  stars.sampleNeighbors(mixed, 0, &rows[0], 9, 1);
+  assert(rows == again);
+
+  // uniform walks on a connected graph that isn't bipartite visit each
+  // vertex in proportion to its degree
+  Graph<int> ring(UNDIRECTED, UNWEIGHTED);
+  const int RING = 12;
+  for(int i = 0; i < RING; i++)
+    ring.insertVertex(i);
+  int edges = 0;
+  for(int i = 0; i < RING; i++)
+  {
+    ring.insertEdge(i, (i + 1) % RING);
+    edges++;
+  }
+  for(int i = 0; i < RING; i += 3)
+  {
+    ring.insertEdge(i, (i + 5) % RING);
+    edges++;
+  }
+  WalkEngine rings(ring);
+  const int WALKS = 200, LENGTH = 2000, BURN_IN = 100;
+  std::vector<int> starts(RING);
+  for(int i = 0; i < RING; i++)
+    starts[i] = i;
+  std::vector<int> walks(RING * WALKS * LENGTH + 1, CANARY), parallel(walks);
+  rings.randomWalks(starts, WALKS, LENGTH, &walks[0], 11, 1);
+  rings.randomWalks(starts, WALKS, LENGTH, &parallel[0], 11, 4);
+  assert(walks == parallel && walks.back() == CANARY);
+  std::vector<long long> visits(RING, 0);
+  long long steps = 0;
+  for(int w = 0; w < RING * WALKS; w++)
+  {
+    const int* path = &walks[static_cast<size_t>(w) * LENGTH];
+    assert(path[0] == starts[w / WALKS]);
+    for(int s = 1; s < LENGTH; s++)
+    {
+      assert(ring.isAdjacentTo(path[s - 1], path[s]));
+      if(s >= BURN_IN)
+      {
+        visits[path[s]]++;
+        steps++;
+      }
+    }
+  }
+  for(int i = 0; i < RING; i++)
+  {
+    double share = ring.neighborsAt(i).size() / (2.0 * edges);
+    assert(std::fabs(visits[i] / static_cast<double>(steps) - share) < 0.1 * share);
+  }
+
+  // a walk stops at a vertex without edges and pads with -1, and an empty
+  // start gives a row of -1
+  Graph<int> path(DIRECTED, UNWEIGHTED);
+  for(int i = 0; i < 3; i++)
+    path.insertVertex(i);
+  path.insertEdge(0, 1);
+  path.insertEdge(1, 2);
+  WalkEngine paths(path);
+  std::vector<int> shortStarts = {0, -1, 5};
+  std::vector<int> padded(3 * 5 + 1, CANARY);
+  paths.randomWalks(shortStarts, 1, 5, &padded[0], 3);
+  std::vector<int> expectedRows = {0, 1, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, CANARY};
+  assert(padded == expectedRows);
+
+  // node2vec: after 0 -> 1, going back to 0 weighs 1/p, to 2 (a neighbour
+  // of 0) 1, and to 3 1/q
+  Graph<int> biased(DIRECTED, UNWEIGHTED);
+  for(int i = 0; i < 4; i++)
+    biased.insertVertex(i);
+  biased.insertEdge(0, 1);
+  biased.insertEdge(0, 2);
+  biased.insertEdge(1, 0);
+  biased.insertEdge(1, 2);
+  biased.insertEdge(1, 3);
+  biased.insertEdge(2, 0);
+  biased.insertEdge(3, 0);
+  WalkEngine biasedWalks(biased);
+  const int BIASED = 100000;
+  std::vector<int> from(1, 0), second(BIASED * 3), secondParallel(BIASED * 3);
+  biasedWalks.node2vecWalks(from, BIASED, 3, 0.5, 2.0, &second[0], 5, 1);
+  biasedWalks.node2vecWalks(from, BIASED, 3, 0.5, 2.0, &secondParallel[0], 5, 4);
+  assert(second == secondParallel);
+  long long through = 0, back = 0, near = 0, away = 0;
+  for(int w = 0; w < BIASED; w++)
+  {
+    if(second[w * 3 + 1] != 1)
+      continue;
+    through++;
+    back += second[w * 3 + 2] == 0;
+    near += second[w * 3 + 2] == 2;
+    away += second[w * 3 + 2] == 3;
+  }
+  assert(expected(through, BIASED, 0.5));
+  assert(expected(back, through, 4.0 / 7) && expected(near, through, 2.0 / 7) && expected(away, through, 1.0 / 7));
+
+  cout << "walk engine tests passed\n";
+  return 0;
+}